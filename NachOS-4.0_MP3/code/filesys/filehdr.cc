@@ -36,6 +36,10 @@
 //	Return FALSE if there are not enough free blocks to accomodate
 //	the new file.
 //
+//	The blocks are taken in one run if there is room, so the file
+//	is read in order without seeking; otherwise, one at a time, each
+//	at the first free block after the last.
+//
 //	"freeMap" is the bit map of free disk sectors
 //	"fileSize" is the bit map of free disk sectors
 //----------------------------------------------------------------------
@@ -43,23 +47,36 @@
 bool
 FileHeader::Allocate(PersistentBitmap *freeMap, int fileSize)
 { 
+    int first, from = 0;
+
     numBytes = fileSize;
     numSectors  = divRoundUp(fileSize, SectorSize);
     if (freeMap->NumClear() < numSectors)
 	return FALSE;		// not enough space
 
+    if (numSectors == 0)
+	return TRUE;
+
+    first = freeMap->FindAndSetRange(numSectors);
+    if (first >= 0) {
+	for (int i = 0; i < numSectors; i++)
+	    dataSectors[i] = first + i;
+	return TRUE;
+    }
     for (int i = 0; i < numSectors; i++) {
-	dataSectors[i] = freeMap->FindAndSet();
+	dataSectors[i] = freeMap->FindAndSet(from);
 	// since we checked that there was enough free space,
 	// we expect this to succeed
 	ASSERT(dataSectors[i] >= 0);
+	from = dataSectors[i] + 1;
     }
     return TRUE;
 }
 
 //----------------------------------------------------------------------
 // FileHeader::Deallocate
-// 	De-allocate all the space allocated for data blocks for this file.
+// 	De-allocate all the space allocated for data blocks for this file,
+//	and tell the disk their contents are no longer needed.
 //
 //	"freeMap" is the bit map of free disk sectors
 //----------------------------------------------------------------------
@@ -70,6 +87,7 @@ FileHeader::Deallocate(PersistentBitmap *freeMap)
     for (int i = 0; i < numSectors; i++) {
 	ASSERT(freeMap->Test((int) dataSectors[i]));  // ought to be marked!
 	freeMap->Clear((int) dataSectors[i]);
+	kernel->synchDisk->Discard((int) dataSectors[i]);
     }
 }
 
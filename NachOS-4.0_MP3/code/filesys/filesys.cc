@@ -22,11 +22,18 @@
 //	kept "open" continuously while Nachos is running.
 //
 //	For those operations (such as Create, Remove) that modify the
-//	directory and/or bitmap, if the operation succeeds, the changes
-//	are written immediately back to disk (the two files are kept
-//	open during all this time).  If the operation fails, and we have
-//	modified part of the directory and/or bitmap, we simply discard
-//	the changed version, without writing it back to disk.
+//	directory, if the operation succeeds, the changes are written
+//	immediately back to disk (the two files are kept open during all
+//	this time).  If the operation fails, and we have modified part of
+//	the directory, we simply discard the changed version, without
+//	writing it back to disk.
+//
+//	The bitmap is loaded once and kept in memory.  Only the sectors
+//	of it that changed are written back, every FreeMapFlushInterval
+//	operations and when Nachos halts.  (On a journaled or
+//	log-structured disk they are written with every operation, to
+//	keep the bitmap consistent with the directory after a crash; the
+//	journal or the segment log absorbs the repeated writes anyway.)
 //
 // 	Our implementation at this point has the following restrictions:
 //
@@ -37,7 +44,9 @@
 //	     number of files can be added to the system
 //	   there is no attempt to make the system robust to failures
 //	    (if Nachos exits in the middle of an operation that modifies
-//	    the file system, it may corrupt the disk)
+//	    the file system, it may corrupt the disk), unless the disk
+//	    was formatted in journaling or log-structured mode
+//	    (cf. journal.h, lfs.h)
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -51,6 +60,10 @@
 #include "directory.h"
 #include "filehdr.h"
 #include "filesys.h"
+#include "journal.h"
+#include "lfs.h"
+#include "synchdisk.h"
+#include "main.h"
 
 // Sectors containing the file headers for the bitmap of free sectors,
 // and the directory of files.  These file headers are placed in well-known 
@@ -65,6 +78,10 @@
 #define NumDirEntries 		10
 #define DirectoryFileSize 	(sizeof(DirectoryEntry) * NumDirEntries)
 
+// How many Create/Remove operations may go by before the in-memory
+// bitmap of free sectors is flushed to disk.
+#define FreeMapFlushInterval	16
+
 //----------------------------------------------------------------------
 // FileSystem::FileSystem
 // 	Initialize the file system.  If format = TRUE, the disk has
@@ -73,22 +90,51 @@
 //	not all of the sectors marked as free).  
 //
 //	If format = FALSE, we just have to open the files
-//	representing the bitmap and the directory.
+//	representing the bitmap and the directory -- after loading the
+//	segment log or replaying the metadata log, if the disk has one.
 //
 //	"format" -- should we initialize the disk?
+//	"layout" -- if formatting, how should the disk be laid out?
 //----------------------------------------------------------------------
 
-FileSystem::FileSystem(bool format)
+FileSystem::FileSystem(bool format, DiskLayout layout)
 { 
     DEBUG(dbgFile, "Initializing the file system.");
+    journal = NULL;
+    log = NULL;
+    freeMapChanges = 0;
     if (format) {
-        PersistentBitmap *freeMap = new PersistentBitmap(NumSectors);
+        freeMap = new PersistentBitmap(NumSectors);
         Directory *directory = new Directory(NumDirEntries);
 	FileHeader *mapHdr = new FileHeader;
 	FileHeader *dirHdr = new FileHeader;
 
         DEBUG(dbgFile, "Formatting the file system.");
 
+    // If we are journaling, set up the log first, so that the rest of
+    // the format goes through it like any other transaction.  Likewise,
+    // a log-structured disk has to be ready before anything is written;
+    // the file system must stay out of the space the log keeps spare.
+	if (layout == JournalLayout) {
+	    journal = new Journal();
+	    journal->Format();
+	    kernel->synchDisk->SetJournal(journal);
+	    journal->Begin();
+	    for (int i = 0; i < JournalSectors; i++)
+		freeMap->Mark(JournalHeaderSector + i);
+	} else if (layout == LogLayout) {
+	    log = new SegmentLog();
+	    log->Format();
+	    kernel->synchDisk->SetLog(log);
+	    for (int i = LogicalSectors; i < NumSectors; i++)
+		freeMap->Mark(i);
+	} else {
+	    char empty[SectorSize];	// so an old log isn't found later
+
+	    bzero(empty, SectorSize);
+	    kernel->synchDisk->WritePhysical(JournalHeaderSector, empty);
+	}
+
     // First, allocate space for FileHeaders for the directory and bitmap
     // (make sure no one else grabs these!)
 	freeMap->Mark(FreeMapSector);	    
@@ -125,20 +171,41 @@ FileSystem::FileSystem(bool format)
         DEBUG(dbgFile, "Writing bitmap and directory back to disk.");
 	freeMap->WriteBack(freeMapFile);	 // flush changes to disk
 	directory->WriteBack(directoryFile);
+	if (journal != NULL)
+	    journal->End();
+	Sync();
 
 	if (debug->IsEnabled('f')) {
 	    freeMap->Print();
 	    directory->Print();
         }
-        delete freeMap; 
 	delete directory; 
 	delete mapHdr; 
 	delete dirHdr;
     } else {
-    // if we are not formatting the disk, just open the files representing
-    // the bitmap and directory; these are left open while Nachos is running
+    // if the disk is log-structured, find out where everything is;
+    // if it has a metadata log, finish any committed updates that did
+    // not make it to their home sectors before the last crash
+	log = new SegmentLog();
+	if (log->Mount())
+	    kernel->synchDisk->SetLog(log);
+	else {
+	    delete log;
+	    log = NULL;
+	    journal = new Journal();
+	    if (journal->Recover())
+		kernel->synchDisk->SetJournal(journal);
+	    else {
+		delete journal;
+		journal = NULL;
+	    }
+	}
+
+    // now just open the files representing the bitmap and directory;
+    // these are left open while Nachos is running
         freeMapFile = new OpenFile(FreeMapSector);
         directoryFile = new OpenFile(DirectorySector);
+	freeMap = new PersistentBitmap(freeMapFile, NumSectors);
     }
 }
 
@@ -154,7 +221,10 @@ FileSystem::FileSystem(bool format)
 // 	  Allocate space on disk for the data blocks for the file
 //	  Add the name to the directory
 //	  Store the new file header on disk 
-//	  Flush the changes to the bitmap and the directory back to disk
+//	  Flush the changes to the directory back to disk (and those
+//	  to the bitmap, if it's time -- see above)
+//
+//	When journaling, the flushed changes form one transaction.
 //
 //	Return TRUE if everything goes ok, otherwise, return FALSE.
 //
@@ -175,41 +245,44 @@ bool
 FileSystem::Create(char *name, int initialSize)
 {
     Directory *directory;
-    PersistentBitmap *freeMap;
     FileHeader *hdr;
     int sector;
     bool success;
 
     DEBUG(dbgFile, "Creating file " << name << " size " << initialSize);
 
+    if (journal != NULL)
+	journal->Begin();
     directory = new Directory(NumDirEntries);
     directory->FetchFrom(directoryFile);
 
     if (directory->Find(name) != -1)
       success = FALSE;			// file is already in directory
     else {	
-        freeMap = new PersistentBitmap(freeMapFile,NumSectors);
         sector = freeMap->FindAndSet();	// find a sector to hold the file header
     	if (sector == -1) 		
             success = FALSE;		// no free block for file header 
-        else if (!directory->Add(name, sector))
+        else if (!directory->Add(name, sector)) {
             success = FALSE;	// no space in directory
-	else {
+	    freeMap->Clear(sector);
+	} else {
     	    hdr = new FileHeader;
-	    if (!hdr->Allocate(freeMap, initialSize))
+	    if (!hdr->Allocate(freeMap, initialSize)) {
             	success = FALSE;	// no space on disk for data
-	    else {	
+		freeMap->Clear(sector);
+	    } else {	
 	    	success = TRUE;
 		// everthing worked, flush all changes back to disk
     	    	hdr->WriteBack(sector); 		
     	    	directory->WriteBack(directoryFile);
-    	    	freeMap->WriteBack(freeMapFile);
+		FreeMapChanged();
 	    }
             delete hdr;
 	}
-        delete freeMap;
     }
     delete directory;
+    if (journal != NULL)
+	journal->End();
     return success;
 }
 
@@ -245,7 +318,8 @@ FileSystem::Open(char *name)
 //	    Remove it from the directory
 //	    Delete the space for its header
 //	    Delete the space for its data blocks
-//	    Write changes to directory, bitmap back to disk
+//	    Write changes to directory (and bitmap, if it's time) back
+//		to disk (as one transaction, when journaling)
 //
 //	Return TRUE if the file was deleted, FALSE if the file wasn't
 //	in the file system.
@@ -257,7 +331,6 @@ bool
 FileSystem::Remove(char *name)
 { 
     Directory *directory;
-    PersistentBitmap *freeMap;
     FileHeader *fileHdr;
     int sector;
     
@@ -271,20 +344,79 @@ FileSystem::Remove(char *name)
     fileHdr = new FileHeader;
     fileHdr->FetchFrom(sector);
 
-    freeMap = new PersistentBitmap(freeMapFile,NumSectors);
+    if (journal != NULL)
+	journal->Begin();
 
     fileHdr->Deallocate(freeMap);  		// remove data blocks
     freeMap->Clear(sector);			// remove header block
+    kernel->synchDisk->Discard(sector);
+    kernel->openFileTable->Detach(sector);
     directory->Remove(name);
 
-    freeMap->WriteBack(freeMapFile);		// flush to disk
     directory->WriteBack(directoryFile);        // flush to disk
+    FreeMapChanged();
+    if (journal != NULL)
+	journal->End();
     delete fileHdr;
     delete directory;
-    delete freeMap;
     return TRUE;
 } 
 
+//----------------------------------------------------------------------
+// FileSystem::Sync
+// 	Make sure every completed operation has reached the disk: write
+//	out what is left of the bitmap of free sectors, and, if the disk
+//	is journaled, commit the transactions still waiting to be grouped,
+//	or if it is log-structured, the segment still being filled.
+//	Called when Nachos halts.
+//----------------------------------------------------------------------
+
+void
+FileSystem::Sync()
+{
+    if (freeMap->IsDirty()) {
+	if (journal != NULL)
+	    journal->Begin();
+	FlushFreeMap();
+	if (journal != NULL)
+	    journal->End();
+    }
+    if (journal != NULL)
+	journal->Commit();
+    if (log != NULL)
+	log->Sync();
+}
+
+//----------------------------------------------------------------------
+// FileSystem::FreeMapChanged
+// 	Called once an operation has changed the in-memory bitmap of free
+//	sectors.  Flush it if the disk layout needs it kept consistent
+//	with the directory, or if enough changes have piled up.
+//----------------------------------------------------------------------
+
+void
+FileSystem::FreeMapChanged()
+{
+    freeMapChanges++;
+    if (journal != NULL || log != NULL
+			|| freeMapChanges >= FreeMapFlushInterval)
+	FlushFreeMap();
+}
+
+//----------------------------------------------------------------------
+// FileSystem::FlushFreeMap
+// 	Write the sectors of the bitmap of free sectors that changed since
+//	the last flush back to disk.
+//----------------------------------------------------------------------
+
+void
+FileSystem::FlushFreeMap()
+{
+    DEBUG(dbgFile, "Flushing free map after " << freeMapChanges << " changes");
+    freeMap->WriteDirty(freeMapFile);
+    freeMapChanges = 0;
+}
+
 //----------------------------------------------------------------------
 // FileSystem::List
 // 	List all the files in the file system directory.
@@ -315,7 +447,6 @@ FileSystem::Print()
 {
     FileHeader *bitHdr = new FileHeader;
     FileHeader *dirHdr = new FileHeader;
-    PersistentBitmap *freeMap = new PersistentBitmap(freeMapFile,NumSectors);
     Directory *directory = new Directory(NumDirEntries);
 
     printf("Bit map file header:\n");
@@ -333,7 +464,6 @@ FileSystem::Print()
 
     delete bitHdr;
     delete dirHdr;
-    delete freeMap;
     delete directory;
 } 
 
@@ -37,6 +37,9 @@
 #include "sysdep.h"
 #include "openfile.h"
 
+class Journal;
+class PersistentBitmap;
+
 #ifdef FILESYS_STUB 		// Temporarily implement file system calls as 
 				// calls to UNIX, until the real file system
 				// implementation is available
@@ -64,14 +67,26 @@ class FileSystem {
 };
 
 #else // FILESYS
+class SegmentLog;
+
+// The ways the disk can be laid out; chosen when it is formatted.
+enum DiskLayout {
+    PlainLayout,			// the baseline layout
+    JournalLayout,			// plus a log of metadata updates
+    LogLayout				// everything written to a sequential
+					// log (cf. lfs.h)
+};
+
 class FileSystem {
   public:
-    FileSystem(bool format);		// Initialize the file system.
+    FileSystem(bool format, DiskLayout layout);
+					// Initialize the file system.
 					// Must be called *after* "synchDisk" 
 					// has been initialized.
     					// If "format", there is nothing on
 					// the disk, so initialize the directory
-    					// and the bitmap of free blocks.
+    					// and the bitmap of free blocks,
+					// using the given "layout".
 
     bool Create(char *name, int initialSize);  	
 					// Create a file (UNIX creat)
@@ -84,11 +99,22 @@ class FileSystem {
 
     void Print();			// List all the files and their contents
 
+    void Sync();			// Force all metadata changes to disk
+
   private:
    OpenFile* freeMapFile;		// Bit map of free disk blocks,
 					// represented as a file
+   PersistentBitmap *freeMap;		// The same bit map, kept in memory
+   int freeMapChanges;			// # of changes since it was flushed
    OpenFile* directoryFile;		// "Root" directory -- list of 
 					// file names, represented as a file
+   Journal *journal;			// Write-ahead log of metadata updates,
+					// NULL if the disk has none
+   SegmentLog *log;			// Log-structured layout, NULL if the
+					// disk isn't laid out that way
+
+   void FreeMapChanged();		// Flush the free map, if it's time
+   void FlushFreeMap();			// Write its changed sectors to disk
 };
 
 #endif // FILESYS
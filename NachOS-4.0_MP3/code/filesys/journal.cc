@@ -0,0 +1,269 @@
+// journal.cc
+//	Routines to manage the write-ahead log of file system metadata.
+//
+//	The log region is laid out as one header sector followed by
+//	NumLogBlocks sectors of logged data.  A group commit is:
+//
+//	   write each captured sector into the log, in order
+//	   write the log header, recording where each one belongs
+//		-- this single sector write is the commit point --
+//	   copy each captured sector to its home location
+//	   write the log header again, with numBlocks = 0
+//
+//	Recovery simply repeats the last two steps if it finds a log
+//	header with numBlocks > 0; installing a sector twice is harmless.
+//
+//	We assume, as does the rest of the baseline file system, that
+//	there are no concurrent file system operations.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+#ifndef FILESYS_STUB
+
+#include "copyright.h"
+#include "debug.h"
+#include "main.h"
+#include "synchdisk.h"
+#include "journal.h"
+
+//----------------------------------------------------------------------
+// Journal::Journal
+// 	Initialize an empty in-memory log.  The log header is not read
+//	from disk until Recover is called.
+//----------------------------------------------------------------------
+
+Journal::Journal()
+{
+    ASSERT(sizeof(JournalHeader) == SectorSize);
+    header = new JournalHeader;
+    header->magic = JournalMagic;
+    header->sequence = 0;
+    header->numBlocks = 0;
+    blocks = new char[NumLogBlocks * SectorSize];
+    numBlocks = 0;
+    numTransactions = 0;
+    inTransaction = FALSE;
+}
+
+//----------------------------------------------------------------------
+// Journal::~Journal
+// 	De-allocate the in-memory log.  Any transactions that were not
+//	committed are lost, just as if Nachos had crashed.
+//----------------------------------------------------------------------
+
+Journal::~Journal()
+{
+    delete header;
+    delete [] blocks;
+}
+
+//----------------------------------------------------------------------
+// Journal::Format
+// 	Write an empty log header, turning the reserved region at the end
+//	of the disk into a log.  The caller is responsible for marking
+//	the log sectors as in use in the free map.
+//----------------------------------------------------------------------
+
+void
+Journal::Format()
+{
+    DEBUG(dbgFile, "Formatting the journal at sector " << JournalHeaderSector);
+    header->magic = JournalMagic;
+    header->sequence = 0;
+    header->numBlocks = 0;
+    kernel->synchDisk->WritePhysical(JournalHeaderSector, (char *)header);
+}
+
+//----------------------------------------------------------------------
+// Journal::Recover
+// 	Read the log header.  If a group of transactions was committed
+//	but may not have reached its home sectors, install it now.
+//
+//	Return FALSE if the disk has no log, ie, it was formatted without
+//	journaling.
+//----------------------------------------------------------------------
+
+bool
+Journal::Recover()
+{
+    char *buf;
+
+    kernel->synchDisk->ReadPhysical(JournalHeaderSector, (char *)header);
+    if (header->magic != JournalMagic)
+	return FALSE;
+    if (header->numBlocks > 0) {
+	DEBUG(dbgFile, "Replaying " << header->numBlocks
+			<< " logged sectors, commit " << header->sequence);
+	ASSERT(header->numBlocks <= NumLogBlocks);
+	buf = new char[header->numBlocks * SectorSize];
+	for (int i = 0; i < header->numBlocks; i++)
+	    kernel->synchDisk->ReadPhysical(JournalHeaderSector + 1 + i,
+						&buf[i * SectorSize]);
+	Install(buf);
+	delete [] buf;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Journal::Begin
+// 	Start a metadata transaction.  Until End is called, every sector
+//	written through the SynchDisk is captured by the log.
+//
+//	If the log might not have room for another transaction, commit
+//	the ones we have first, so that a transaction is never split
+//	across two group commits.
+//----------------------------------------------------------------------
+
+void
+Journal::Begin()
+{
+    ASSERT(!inTransaction);
+    if (numBlocks + MaxTransactionBlocks > NumLogBlocks)
+	Commit();
+    inTransaction = TRUE;
+}
+
+//----------------------------------------------------------------------
+// Journal::End
+// 	Finish a metadata transaction.  The transaction is now part of
+//	the current group; commit the group once it is big enough.
+//----------------------------------------------------------------------
+
+void
+Journal::End()
+{
+    ASSERT(inTransaction);
+    inTransaction = FALSE;
+    numTransactions++;
+    if (numTransactions >= TransactionsPerCommit)
+	Commit();
+}
+
+//----------------------------------------------------------------------
+// Journal::Commit
+// 	Write every finished transaction to the log, then to the home
+//	locations.  See the comment at the top of the file for the order
+//	of the writes.
+//----------------------------------------------------------------------
+
+void
+Journal::Commit()
+{
+    ASSERT(!inTransaction);
+    if (numBlocks == 0) {
+	numTransactions = 0;
+	return;
+    }
+    DEBUG(dbgFile, "Committing " << numTransactions << " transactions, "
+			<< numBlocks << " sectors");
+
+    for (int i = 0; i < numBlocks; i++)
+	kernel->synchDisk->WritePhysical(JournalHeaderSector + 1 + i,
+						&blocks[i * SectorSize]);
+    header->numBlocks = numBlocks;
+    header->sequence++;
+    kernel->synchDisk->WritePhysical(JournalHeaderSector, (char *)header);
+
+    Install(blocks);
+
+    numBlocks = 0;
+    numTransactions = 0;
+}
+
+//----------------------------------------------------------------------
+// Journal::Absorb
+// 	Called by SynchDisk::WriteSector.  If we are inside a transaction,
+//	or if an earlier version of the sector is still waiting in the
+//	log, keep the new contents here rather than writing them to disk
+//	(otherwise the group commit would later overwrite them with the
+//	stale copy).
+//
+//	Return TRUE if the write was captured.
+//
+//	"sector" -- the home sector being written
+//	"data" -- the new contents of the sector
+//----------------------------------------------------------------------
+
+bool
+Journal::Absorb(int sector, char *data)
+{
+    int which = FindBlock(sector);
+
+    if (which == -1) {
+	if (!inTransaction)
+	    return FALSE;
+	ASSERT(numBlocks < NumLogBlocks);	// see MaxTransactionBlocks
+	which = numBlocks++;
+	header->home[which] = sector;
+    }
+    bcopy(data, &blocks[which * SectorSize], SectorSize);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Journal::Lookup
+// 	Called by SynchDisk::ReadSector.  If the sector has been written
+//	since the last group commit, the up to date copy is in the log.
+//
+//	Return TRUE if the sector was found.
+//
+//	"sector" -- the home sector being read
+//	"data" -- the buffer to hold the contents of the sector
+//----------------------------------------------------------------------
+
+bool
+Journal::Lookup(int sector, char *data)
+{
+    int which = FindBlock(sector);
+
+    if (which == -1)
+	return FALSE;
+    bcopy(&blocks[which * SectorSize], data, SectorSize);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Journal::FindBlock
+// 	Return the position of "sector" among the captured sectors, or
+//	-1 if it is not there.  The log is small, so a linear scan will do.
+//----------------------------------------------------------------------
+
+int
+Journal::FindBlock(int sector)
+{
+    for (int i = 0; i < numBlocks; i++)
+	if (header->home[i] == sector)
+	    return i;
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Journal::Install
+// 	Copy the logged sectors to their home locations, then mark the
+//	log as empty.  The sectors are written in increasing order to
+//	cut down on seeks.
+//
+//	"from" -- the contents of the logged sectors, in log order
+//----------------------------------------------------------------------
+
+void
+Journal::Install(char *from)
+{
+    int next, last = -1;
+
+    for (int n = 0; n < header->numBlocks; n++) {
+	next = -1;			// smallest home sector above "last"
+	for (int i = 0; i < header->numBlocks; i++)
+	    if (header->home[i] > last
+		    && (next == -1 || header->home[i] < header->home[next]))
+		next = i;
+	last = header->home[next];
+	kernel->synchDisk->WritePhysical(last, &from[next * SectorSize]);
+    }
+    header->numBlocks = 0;
+    kernel->synchDisk->WritePhysical(JournalHeaderSector, (char *)header);
+}
+
+#endif // FILESYS_STUB
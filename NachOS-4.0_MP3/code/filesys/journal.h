@@ -0,0 +1,92 @@
+// journal.h
+//	Data structures for a write-ahead log of file system metadata.
+//
+//	When the disk is formatted in journaling mode, a fixed region
+//	at the end of the disk is set aside as a log.  Updates to the
+//	free map, the directory and the file headers are not written
+//	to their "home" sectors directly; instead they are collected in
+//	memory as part of a transaction.  Several transactions are
+//	grouped together and committed at once, by writing the new
+//	sector images sequentially into the log, then writing the log
+//	header (the commit point), and only then installing the sectors
+//	at their home locations.
+//
+//	If Nachos crashes before the log header is written, none of the
+//	grouped transactions happened; if it crashes afterwards, the
+//	log is replayed the next time the file system is mounted.  Either
+//	way the disk is left consistent.
+//
+//	A sector that is written several times before the group commits
+//	is only logged and installed once, so metadata-heavy workloads
+//	issue far fewer (and mostly sequential) disk writes.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "copyright.h"
+#include "disk.h"
+
+#define JournalMagic		0x4a524e4c	// "JRNL" -- marks a journaled disk
+
+// The log header has to fit in a single sector, so that writing it
+// is atomic; this bounds the number of sectors in one group commit.
+#define NumLogBlocks 		((int) (SectorSize / sizeof(int)) - 3)
+#define JournalSectors 		(1 + NumLogBlocks)
+#define JournalHeaderSector 	(NumSectors - JournalSectors)
+
+#define MaxTransactionBlocks	8	// sectors touched by one Create/Remove
+#define TransactionsPerCommit	8	// group commit after this many
+
+// The following class defines the on-disk log header.  "numBlocks"
+// is zero unless a group of transactions has been committed to the
+// log but not yet (completely) installed at the home locations.
+
+class JournalHeader {
+  public:
+    int magic;				// JournalMagic if the disk has a log
+    int sequence;			// number of group commits so far
+    int numBlocks;			// # of valid sectors in the log
+    int home[NumLogBlocks];		// home sector of each logged sector
+};
+
+// The following class defines the in-memory side of the log.  The
+// SynchDisk hands it every sector write and read (cf. synchdisk.cc);
+// writes made inside a transaction, or to a sector that is already
+// waiting in the log, are captured here instead of going to the disk.
+
+class Journal {
+  public:
+    Journal();				// Initialize an empty log
+    ~Journal();
+
+    void Format();			// Write an empty log header to disk
+    bool Recover();			// Replay a committed log, if any.
+					// Return FALSE if the disk was not
+					// formatted in journaling mode.
+
+    void Begin();			// Start a metadata transaction
+    void End();				// Finish it; may cause a group commit
+    void Commit();			// Force all finished transactions
+					// to disk
+
+    bool Absorb(int sector, char *data); // Capture a sector write, if
+					// it belongs in the log
+    bool Lookup(int sector, char *data); // Return the logged copy of a
+					// sector, if there is one
+
+  private:
+    JournalHeader *header;		// in-memory copy of the log header
+    char *blocks;			// sector images waiting to be logged
+    int numBlocks;			// # of sectors in "blocks"
+    int numTransactions;		// # of finished, uncommitted transactions
+    bool inTransaction;			// between Begin and End?
+
+    int FindBlock(int sector);		// index of "sector" in "blocks", or -1
+    void Install(char *from);		// copy logged sectors to their homes
+};
+
+#endif // JOURNAL_H
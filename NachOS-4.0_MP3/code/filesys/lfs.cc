@@ -0,0 +1,523 @@
+// lfs.cc
+//	Routines to manage a log-structured disk layout.
+//
+//	Physical layout of the disk:
+//
+//	   track 0	two checkpoint slots, each a CheckpointHeader
+//			followed by the inode map
+//	   tracks 1..	the segments, one per track
+//
+//	Sector writes are appended to an in-memory copy of the active
+//	segment.  When it fills up it is written out in one pass, and the
+//	next clean segment becomes active.  Every CheckpointInterval
+//	segments (and on Sync) the inode map is checkpointed.
+//
+//	The disk takes a request for one sector at a time, and by the
+//	time the next request arrives the head has already passed the
+//	following sector.  So a segment is written in two sweeps, even
+//	sectors then odd ones, which lets each write start at the next
+//	sector boundary instead of waiting a whole revolution.
+//
+//	Invariants, with "lock" held:
+//	   imap[l] == p  iff  owner[p] == l
+//	   live[s] is the number of mapped sectors in segment s
+//	   a physical sector in the active segment, at a slot >= "flushed",
+//	     is only in "buffer", not yet on disk
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+#ifndef FILESYS_STUB
+
+#include "copyright.h"
+#include "debug.h"
+#include "main.h"
+#include "synchdisk.h"
+#include "lfs.h"
+
+// physical sector <-> (segment, slot)
+#define SegmentOf(p)		((p) / SegmentSize - 1)
+#define SlotOf(p)		((p) % SegmentSize)
+#define SegmentStart(s)		(((s) + 1) * SegmentSize)
+
+// The cleaner is a kernel thread, not a user process.
+#define CleanerThreadID		-1
+
+// Debugging names of the log's lock, and of the cleaner and its semaphore
+static char logName[] = "segment log";
+static char cleanerName[] = "segment cleaner";
+
+//----------------------------------------------------------------------
+// CleanerThread
+// 	Entry point for the cleaner thread; "arg" is the segment log.
+//----------------------------------------------------------------------
+
+static void
+CleanerThread(void *arg)
+{
+    ((SegmentLog *) arg)->RunCleaner();
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::SegmentLog
+// 	Initialize an empty log; nothing is read from or written to the
+//	disk until Format or Mount is called.
+//----------------------------------------------------------------------
+
+SegmentLog::SegmentLog()
+{
+    ASSERT(1 + MapSectors <= CheckpointSlotSize);
+    lock = new Lock(logName);
+    imap = new short[MapSectors * SectorSize / sizeof(short)];
+    owner = new short[NumSectors];
+    buffer = new char[SegmentSize * SectorSize];
+    for (unsigned int i = 0; i < MapSectors * SectorSize / sizeof(short); i++)
+	imap[i] = -1;
+    for (int i = 0; i < NumSectors; i++)
+	owner[i] = -1;
+    for (int i = 0; i < NumSegments; i++) {
+	live[i] = 0;
+	state[i] = SegClean;
+    }
+    active = -1;
+    used = flushed = 0;
+    sequence = 0;
+    nextSlot = 0;
+    sinceCheckpoint = 0;
+    cleaning = FALSE;
+    cleanerAwake = FALSE;
+    cleaner = NULL;
+    cleanerWait = new Semaphore(cleanerName, 0);
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::~SegmentLog
+// 	De-allocate the log.  Anything not yet checkpointed is lost, as
+//	if Nachos had crashed.
+//----------------------------------------------------------------------
+
+SegmentLog::~SegmentLog()
+{
+    delete lock;
+    delete [] imap;
+    delete [] owner;
+    delete [] buffer;
+    delete cleanerWait;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Format
+// 	Lay out an empty log: every segment clean, nothing mapped.
+//	Invalidate the second checkpoint slot, so that an old checkpoint
+//	left there by a previous format isn't mistaken for a newer one.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Format()
+{
+    char empty[SectorSize];
+
+    DEBUG(dbgFile, "Formatting a log-structured disk, "
+		<< NumSegments << " segments");
+    bzero(empty, SectorSize);
+    kernel->synchDisk->WritePhysical(CheckpointSlotSize, empty);
+
+    lock->Acquire();
+    NextSegment();
+    Checkpoint();
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Mount
+// 	Load the newer of the two checkpoints, and work out from the inode
+//	map how much live data each segment holds.
+//
+//	Return FALSE if the disk isn't log-structured (there is no
+//	checkpoint header in the first slot).
+//----------------------------------------------------------------------
+
+bool
+SegmentLog::Mount()
+{
+    CheckpointHeader *header;
+    char buf[SectorSize];
+    int seq0, seq1;
+    bool ok0, ok1;
+
+    kernel->synchDisk->ReadPhysical(0, buf);
+    header = (CheckpointHeader *) buf;
+    if (header->magic != LfsMagic)
+	return FALSE;
+
+    // read both slots, then re-read the newer valid one
+    ok0 = ReadCheckpoint(0, &seq0);
+    ok1 = ReadCheckpoint(1, &seq1);
+    ASSERT(ok0 || ok1);
+    if (ok1 && (!ok0 || seq1 > seq0)) {
+	sequence = seq1;
+	nextSlot = 0;
+    } else {
+	ok0 = ReadCheckpoint(0, &seq0);
+	sequence = seq0;
+	nextSlot = 1;
+    }
+    DEBUG(dbgFile, "Mounting log-structured disk at checkpoint " << sequence);
+
+    for (int l = 0; l < LogicalSectors; l++)
+	if (imap[l] >= 0) {
+	    owner[imap[l]] = l;
+	    live[SegmentOf(imap[l])]++;
+	}
+    for (int s = 0; s < NumSegments; s++)
+	state[s] = (live[s] > 0) ? SegDirty : SegClean;
+
+    lock->Acquire();
+    NextSegment();
+    lock->Release();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::ReadSector
+// 	Read the current contents of a logical sector.  A sector that was
+//	never written reads as zeroes.
+//
+//	"sector" -- the logical sector to read
+//	"data" -- the buffer to hold the contents of the sector
+//----------------------------------------------------------------------
+
+void
+SegmentLog::ReadSector(int sector, char *data)
+{
+    int p;
+
+    ASSERT(sector >= 0 && sector < LogicalSectors);
+    lock->Acquire();
+    p = imap[sector];
+    if (p < 0)
+	bzero(data, SectorSize);
+    else if (SegmentOf(p) == active && SlotOf(p) < used)
+	bcopy(&buffer[SlotOf(p) * SectorSize], data, SectorSize);
+    else
+	kernel->synchDisk->ReadPhysical(p, data);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::WriteSector
+// 	Write a logical sector by appending it to the active segment.  If
+//	the previous copy is still in the unwritten part of the segment,
+//	just overwrite it there.
+//
+//	"sector" -- the logical sector to write
+//	"data" -- the new contents of the sector
+//----------------------------------------------------------------------
+
+void
+SegmentLog::WriteSector(int sector, char *data)
+{
+    int p;
+
+    ASSERT(sector >= 0 && sector < LogicalSectors);
+    lock->Acquire();
+    p = imap[sector];
+    if (p >= 0 && SegmentOf(p) == active && SlotOf(p) >= flushed)
+	bcopy(data, &buffer[SlotOf(p) * SectorSize], SectorSize);
+    else
+	Append(sector, data);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Discard
+// 	Forget a logical sector, so the cleaner won't copy it any more.
+//
+//	"sector" -- the logical sector the file system has freed
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Discard(int sector)
+{
+    ASSERT(sector >= 0 && sector < LogicalSectors);
+    lock->Acquire();
+    Unmap(sector);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Sync
+// 	Write out the partly filled segment and take a checkpoint, so
+//	that everything written so far survives a crash.
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Sync()
+{
+    lock->Acquire();
+    Checkpoint();
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::RunCleaner
+// 	The cleaner thread.  Sleep until the number of clean segments
+//	drops below CleanLowWater, then clean until there are
+//	CleanHighWater of them again -- or until there is nothing left
+//	that is worth cleaning (segments that are mostly live).
+//----------------------------------------------------------------------
+
+void
+SegmentLog::RunCleaner()
+{
+    for (;;) {
+	cleanerWait->P();
+	lock->Acquire();
+	cleanerAwake = FALSE;
+	while (NumClean() < CleanHighWater
+			&& CleanOne(SegmentSize * 3 / 4))
+	    ;
+	lock->Release();
+    }
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Append
+// 	Put a new copy of a logical sector in the next free slot of the
+//	active segment, and write the segment out if it is now full.
+//	Caller holds "lock".
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Append(int sector, char *data)
+{
+    int p;
+
+    ASSERT(active >= 0 && used < SegmentSize);
+    Unmap(sector);
+    p = SegmentStart(active) + used;
+    bcopy(data, &buffer[used * SectorSize], SectorSize);
+    used++;
+    imap[sector] = p;
+    owner[p] = sector;
+    live[active]++;
+
+    if (used == SegmentSize) {
+	Flush();
+	if (++sinceCheckpoint >= CheckpointInterval)
+	    Checkpoint();
+	NextSegment();
+    }
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Unmap
+// 	Drop the current copy of a logical sector, if any.  A segment
+//	whose last live sector goes away can be reused after the next
+//	checkpoint.  Caller holds "lock".
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Unmap(int sector)
+{
+    int p = imap[sector];
+    int s;
+
+    if (p < 0)
+	return;
+    s = SegmentOf(p);
+    imap[sector] = -1;
+    owner[p] = -1;
+    live[s]--;
+    if (live[s] == 0 && state[s] == SegDirty)
+	state[s] = SegFreed;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Flush
+// 	Write the filled but unwritten slots of the active segment to
+//	disk: even slots first, then odd ones (see the top of the file).
+//	Caller holds "lock".
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Flush()
+{
+    for (int pass = 0; pass < 2; pass++)
+	for (int slot = flushed; slot < used; slot++)
+	    if (slot % 2 == pass)
+		kernel->synchDisk->WritePhysical(SegmentStart(active) + slot,
+					&buffer[slot * SectorSize]);
+    flushed = used;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::NextSegment
+// 	Retire the active segment (if any) and make a clean one active.
+//
+//	Ordinary writers leave CleanReserve segments for the cleaner; if
+//	they would have to dip into them, they clean in the foreground.
+//	Either way, wake the background cleaner when clean segments are
+//	getting scarce.  Caller holds "lock".
+//----------------------------------------------------------------------
+
+void
+SegmentLog::NextSegment()
+{
+    int s;
+
+    if (active >= 0)
+	state[active] = (live[active] > 0) ? SegDirty : SegFreed;
+    for (s = 0; s < NumSegments; s++)
+	if (state[s] == SegClean)
+	    break;
+    ASSERT(s < NumSegments);		// the cleaner's reserve is gone
+    state[s] = SegActive;
+    active = s;
+    used = flushed = 0;
+    DEBUG(dbgFile, "Segment " << s << " is now active, "
+		<< NumClean() << " clean");
+
+    if (cleaning)
+	return;
+    while (NumClean() < CleanReserve && CleanOne(SegmentSize - 1))
+	;
+    if (NumClean() < CleanLowWater && !cleanerAwake) {
+	if (cleaner == NULL) {
+	    cleaner = new Thread(cleanerName, CleanerThreadID, 0);
+	    cleaner->Fork((VoidFunctionPtr) CleanerThread, (void *) this);
+	}
+	cleanerAwake = TRUE;
+	cleanerWait->V();
+    }
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::CleanOne
+// 	Clean the segment with the least live data, by appending its live
+//	sectors to the log; then checkpoint, so that it can be reused.
+//	Caller holds "lock".
+//
+//	Return FALSE if every candidate has more than "maxLive" live
+//	sectors (cleaning it would not gain enough).
+//----------------------------------------------------------------------
+
+bool
+SegmentLog::CleanOne(int maxLive)
+{
+    char data[SectorSize];
+    int victim = -1;
+    int p;
+
+    for (int s = 0; s < NumSegments; s++)
+	if (state[s] == SegDirty && (victim == -1 || live[s] < live[victim]))
+	    victim = s;
+    if (victim == -1 || live[victim] > maxLive)
+	return FALSE;
+
+    DEBUG(dbgFile, "Cleaning segment " << victim << ", "
+		<< live[victim] << " live sectors");
+    cleaning = TRUE;
+    for (int slot = 0; slot < SegmentSize && live[victim] > 0; slot++) {
+	p = SegmentStart(victim) + slot;
+	if (owner[p] >= 0) {
+	    kernel->synchDisk->ReadPhysical(p, data);
+	    Append(owner[p], data);
+	}
+    }
+    cleaning = FALSE;
+    Checkpoint();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Checkpoint
+// 	Write out the active segment so far, then the inode map and the
+//	checkpoint header, into the older of the two slots.  The header
+//	goes last; its checksum tells a half-written slot from a good one.
+//	Segments freed since the last checkpoint are now clean.
+//	Caller holds "lock".
+//----------------------------------------------------------------------
+
+void
+SegmentLog::Checkpoint()
+{
+    char buf[SectorSize];
+    CheckpointHeader *header = (CheckpointHeader *) buf;
+    int base = nextSlot * CheckpointSlotSize;
+
+    Flush();
+    for (int i = 0; i < MapSectors; i++)
+	kernel->synchDisk->WritePhysical(base + 1 + i,
+			&((char *) imap)[i * SectorSize]);
+    bzero(buf, SectorSize);
+    header->magic = LfsMagic;
+    header->sequence = ++sequence;
+    header->checksum = Checksum(sequence);
+    kernel->synchDisk->WritePhysical(base, buf);
+    DEBUG(dbgFile, "Checkpoint " << sequence << " in slot " << nextSlot);
+
+    nextSlot = 1 - nextSlot;
+    sinceCheckpoint = 0;
+    for (int s = 0; s < NumSegments; s++)
+	if (state[s] == SegFreed)
+	    state[s] = SegClean;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::ReadCheckpoint
+// 	Read the inode map from checkpoint slot "slot".  Return TRUE if
+//	the slot holds a complete checkpoint, and its sequence number
+//	in "seq".
+//----------------------------------------------------------------------
+
+bool
+SegmentLog::ReadCheckpoint(int slot, int *seq)
+{
+    char buf[SectorSize];
+    CheckpointHeader *header = (CheckpointHeader *) buf;
+    int base = slot * CheckpointSlotSize;
+
+    kernel->synchDisk->ReadPhysical(base, buf);
+    if (header->magic != LfsMagic)
+	return FALSE;
+    for (int i = 0; i < MapSectors; i++)
+	kernel->synchDisk->ReadPhysical(base + 1 + i,
+			&((char *) imap)[i * SectorSize]);
+    *seq = header->sequence;
+    return (header->checksum == Checksum(header->sequence));
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::Checksum
+// 	A simple checksum of the inode map and the sequence number "seq",
+//	unsigned so that it can wrap around.
+//----------------------------------------------------------------------
+
+unsigned int
+SegmentLog::Checksum(int seq)
+{
+    unsigned int sum = seq;
+
+    for (int l = 0; l < LogicalSectors; l++)
+	sum = sum * 31 + imap[l];
+    return sum;
+}
+
+//----------------------------------------------------------------------
+// SegmentLog::NumClean
+// 	Return the number of segments that can be made active.
+//----------------------------------------------------------------------
+
+int
+SegmentLog::NumClean()
+{
+    int n = 0;
+
+    for (int s = 0; s < NumSegments; s++)
+	if (state[s] == SegClean)
+	    n++;
+    return n;
+}
+
+#endif // FILESYS_STUB
@@ -0,0 +1,121 @@
+// lfs.h
+//	Data structures for a log-structured disk layout.
+//
+//	When the disk is formatted in log-structured mode, sectors no
+//	longer live at fixed places on the disk.  Every write -- file
+//	data, file headers, the directory and the free map alike -- is
+//	appended to the current "segment", which is buffered in memory
+//	and written out sequentially once it fills up.  So a stream of
+//	random writes costs about the same as a sequential one.
+//
+//	The "inode map" records where the latest copy of each sector is.
+//	In Nachos a file is named by the sector holding its header, so
+//	mapping every sector covers the headers and the data blocks in
+//	one table.  The map is saved in a checkpoint region on track 0,
+//	alternating between two slots so that one of them is always
+//	intact.  After a crash we restart from the newer valid checkpoint;
+//	writes since then are lost, but the disk is consistent.
+//
+//	Overwritten sectors leave dead copies behind in old segments.  A
+//	background "cleaner" thread picks segments with little live data,
+//	copies the live sectors to the head of the log, and so makes the
+//	old segments reusable.
+//
+//	The file system sees a smaller disk (LogicalSectors) than the
+//	physical one, so that there is always free space for the cleaner.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef LFS_H
+#define LFS_H
+
+#include "copyright.h"
+#include "disk.h"
+#include "synch.h"
+
+#define LfsMagic		0x4c4f4753	// "LOGS" -- marks a log-structured disk
+
+#define SegmentSize		SectorsPerTrack	// one segment per track
+#define NumSegments		(NumTracks - 1)	// track 0 holds the checkpoints
+#define LogicalSectors		(NumSectors * 3 / 4)
+					// size of the disk, as seen by
+					// the file system
+#define MapSectors		((int) divRoundUp(LogicalSectors * sizeof(short), SectorSize))
+#define CheckpointSlotSize	(SectorsPerTrack / 2)
+
+#define CheckpointInterval	4	// checkpoint after this many segments
+#define CleanReserve		2	// segments only the cleaner may use
+#define CleanLowWater		4	// wake the cleaner below this many
+#define CleanHighWater		6	// and let it go back to sleep here
+
+// The following class defines the header sector of a checkpoint.
+// It is followed on disk by the inode map, MapSectors long.
+
+class CheckpointHeader {
+  public:
+    int magic;				// LfsMagic
+    int sequence;			// checkpoints taken so far
+    unsigned int checksum;		// of the inode map, to detect a
+					// checkpoint that was only half written
+};
+
+// The following class defines the log.  It sits below the SynchDisk
+// interface (cf. synchdisk.cc); the file system above it is unchanged.
+
+class SegmentLog {
+  public:
+    SegmentLog();			// Initialize an empty log
+    ~SegmentLog();
+
+    void Format();			// Lay out an empty log on the disk
+    bool Mount();			// Load the newest checkpoint.  Return
+					// FALSE if the disk isn't log-structured
+
+    void ReadSector(int sector, char *data);
+    void WriteSector(int sector, char *data);
+					// Read/write a (logical) sector
+    void Discard(int sector);		// The file system freed "sector"
+    void Sync();			// Flush the segment and checkpoint
+
+    void RunCleaner();			// Body of the cleaner thread
+
+  private:
+    enum SegmentState { SegClean, SegActive, SegDirty, SegFreed };
+					// SegFreed: no live data, but still
+					// named by the last checkpoint, so it
+					// can't be reused until the next one
+
+    Lock *lock;				// protects everything below
+    short *imap;			// logical sector -> physical, or -1
+    short *owner;			// physical sector -> logical, or -1
+    int live[NumSegments];		// # of live sectors in each segment
+    SegmentState state[NumSegments];
+
+    int active;				// segment being filled
+    char *buffer;			// its contents
+    int used;				// # of slots filled in "buffer"
+    int flushed;			// # of those already on disk
+
+    int sequence;			// of the last checkpoint
+    int nextSlot;			// checkpoint slot to write next
+    int sinceCheckpoint;		// segments written since then
+
+    bool cleaning;			// relocating live data right now?
+    bool cleanerAwake;			// has the cleaner been signalled?
+    Thread *cleaner;			// the cleaner thread, once started
+    Semaphore *cleanerWait;		// the cleaner sleeps here
+
+    void Append(int sector, char *data);
+    void Unmap(int sector);
+    void Flush();
+    void NextSegment();
+    bool CleanOne(int maxLive);
+    void Checkpoint();
+    bool ReadCheckpoint(int slot, int *seq);
+    unsigned int Checksum(int seq);
+    int NumClean();
+};
+
+#endif // LFS_H
@@ -5,7 +5,9 @@
 //	the OpenFile data structure).
 //
 //	Also as in UNIX, for convenience, we keep the file header in
-//	memory while the file is open.
+//	memory while the file is open.  Opening the same file again doesn't
+//	read the header again: the kernel keeps a table of the headers of
+//	open files, shared by every OpenFile on the same file.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -18,29 +20,133 @@
 #include "openfile.h"
 #include "synchdisk.h"
 
+//----------------------------------------------------------------------
+// EntrySector, HashSector
+//	Functions the table of open files needs to find an entry: the key
+//	of an entry is the sector of its file header.
+//----------------------------------------------------------------------
+
+static int
+EntrySector(OpenFileEntry *entry)
+{
+    return entry->sector;
+}
+
+static unsigned int
+HashSector(int sector)
+{
+    return (unsigned int) sector;
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::OpenFileTable
+// 	Initialize an empty table of open files.
+//----------------------------------------------------------------------
+
+OpenFileTable::OpenFileTable()
+{
+    table = new HashTable<int, OpenFileEntry *>(EntrySector, HashSector);
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::~OpenFileTable
+// 	De-allocate the table.  Any files still open are leaked, as they
+//	would be by the baseline file system.
+//----------------------------------------------------------------------
+
+OpenFileTable::~OpenFileTable()
+{
+    delete table;
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::Acquire
+// 	Return the entry for the file whose header is at "sector", with one
+//	more reference.  The header is only read from disk if the file
+//	isn't open already.
+//
+//	"sector" -- the location on disk of the file header
+//----------------------------------------------------------------------
+
+OpenFileEntry *
+OpenFileTable::Acquire(int sector)
+{
+    OpenFileEntry *entry;
+
+    if (!table->Find(sector, &entry)) {
+	DEBUG(dbgFile, "Fetching header of open file at sector " << sector);
+	entry = new OpenFileEntry;
+	entry->sector = sector;
+	entry->hdr = new FileHeader;
+	entry->hdr->FetchFrom(sector);
+	entry->refCount = 0;
+	entry->detached = FALSE;
+	table->Insert(entry);
+    }
+    entry->refCount++;
+    return entry;
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::Release
+// 	Drop a reference to "entry"; once nobody uses it, take it out of
+//	the table and de-allocate the file header.
+//----------------------------------------------------------------------
+
+void
+OpenFileTable::Release(OpenFileEntry *entry)
+{
+    ASSERT(entry->refCount > 0);
+    if (--entry->refCount > 0)
+	return;
+    if (!entry->detached)
+	table->Remove(entry->sector);
+    delete entry->hdr;
+    delete entry;
+}
+
+//----------------------------------------------------------------------
+// OpenFileTable::Detach
+// 	The file whose header is at "sector" is being deleted.  Files
+//	already open keep using the old header until they are closed, but
+//	the sector may be reused for a new file, which must not find it.
+//----------------------------------------------------------------------
+
+void
+OpenFileTable::Detach(int sector)
+{
+    OpenFileEntry *entry;
+
+    if (table->Find(sector, &entry)) {
+	table->Remove(sector);
+	entry->detached = TRUE;
+    }
+}
+
 //----------------------------------------------------------------------
 // OpenFile::OpenFile
 // 	Open a Nachos file for reading and writing.  Bring the file header
-//	into memory while the file is open.
+//	into memory while the file is open, unless it is there already.
 //
 //	"sector" -- the location on disk of the file header for this file
 //----------------------------------------------------------------------
 
 OpenFile::OpenFile(int sector)
 { 
-    hdr = new FileHeader;
-    hdr->FetchFrom(sector);
+    entry = kernel->openFileTable->Acquire(sector);
+    hdr = entry->hdr;
     seekPosition = 0;
 }
 
 //----------------------------------------------------------------------
 // OpenFile::~OpenFile
-// 	Close a Nachos file, de-allocating any in-memory data structures.
+// 	Close a Nachos file, de-allocating any in-memory data structures
+//	nobody else is using.
 //----------------------------------------------------------------------
 
 OpenFile::~OpenFile()
 {
-    delete hdr;
+    kernel->openFileTable->Release(entry);
 }
 
 //----------------------------------------------------------------------
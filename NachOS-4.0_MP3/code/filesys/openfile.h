@@ -13,6 +13,10 @@
 //	worry about concurrent accesses to the file system
 //	by different threads.
 //
+//	In the real implementation, every OpenFile on the same file shares
+//	one in-memory copy of the file header, found through the kernel's
+//	table of open files; each OpenFile keeps its own seek position.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -60,8 +64,41 @@ class OpenFile {
 };
 
 #else // FILESYS
+#include "hash.h"
+
 class FileHeader;
 
+// The following class defines an entry in the table of open files:
+// the file header, shared by every OpenFile on the file.
+
+class OpenFileEntry {
+  public:
+    int sector;				// where the header lives on disk
+    FileHeader *hdr;			// the header itself
+    int refCount;			// # of OpenFiles using it
+    bool detached;			// removed from the table (the file
+					// was deleted while it was open)?
+};
+
+// The following class defines the system-wide table of open files,
+// keyed by the sector of the file header.
+
+class OpenFileTable {
+  public:
+    OpenFileTable();			// Initialize an empty table
+    ~OpenFileTable();
+
+    OpenFileEntry *Acquire(int sector);	// Find or fetch the header
+					// at "sector", and add a reference
+    void Release(OpenFileEntry *entry);	// Drop a reference; free the
+					// header when it was the last one
+    void Detach(int sector);		// The file is being deleted; later
+					// opens of "sector" get a new entry
+
+  private:
+    HashTable<int, OpenFileEntry *> *table;
+};
+
 class OpenFile {
   public:
     OpenFile(int sector);		// Open a file whose header is located
@@ -88,7 +125,8 @@ class OpenFile {
 					// end of file, tell, lseek back 
     
   private:
-    FileHeader *hdr;			// Header for this file 
+    OpenFileEntry *entry;		// Entry in the table of open files
+    FileHeader *hdr;			// Header for this file (shared)
     int seekPosition;			// Current position within the file
 };
 
@@ -8,6 +8,7 @@
 
 #include "copyright.h"
 #include "pbitmap.h"
+#include "disk.h"
 
 //----------------------------------------------------------------------
 // PersistentBitmap::PersistentBitmap(int)
@@ -21,6 +22,9 @@
 
 PersistentBitmap::PersistentBitmap(int numItems):Bitmap(numItems) 
 { 
+    onDisk = new unsigned int[numWords];
+    for (int i = 0; i < numWords; i++)
+	onDisk[i] = ~map[i];		// nothing is on disk yet
 }
 
 //----------------------------------------------------------------------
@@ -40,7 +44,8 @@ PersistentBitmap::PersistentBitmap(OpenFile *file, int numItems):Bitmap(numItems
     // map has already been initialized by the BitMap constructor,
     // but we will just overwrite that with the contents of the
     // map found in the file
-    file->ReadAt((char *)map, numWords * sizeof(unsigned), 0);
+    onDisk = new unsigned int[numWords];
+    FetchFrom(file);
 }
 
 //----------------------------------------------------------------------
@@ -50,6 +55,7 @@ PersistentBitmap::PersistentBitmap(OpenFile *file, int numItems):Bitmap(numItems
 
 PersistentBitmap::~PersistentBitmap()
 { 
+    delete [] onDisk;
 }
 
 //----------------------------------------------------------------------
@@ -63,6 +69,7 @@ void
 PersistentBitmap::FetchFrom(OpenFile *file) 
 {
     file->ReadAt((char *)map, numWords * sizeof(unsigned), 0);
+    bcopy((char *)map, (char *)onDisk, numWords * sizeof(unsigned));
 }
 
 //----------------------------------------------------------------------
@@ -76,4 +83,49 @@ void
 PersistentBitmap::WriteBack(OpenFile *file)
 {
    file->WriteAt((char *)map, numWords * sizeof(unsigned), 0);
+   bcopy((char *)map, (char *)onDisk, numWords * sizeof(unsigned));
+}
+
+//----------------------------------------------------------------------
+// PersistentBitmap::WriteDirty
+// 	Store the words that changed since the bitmap was last read or
+//	written.  The disk can only transfer whole sectors, so write each
+//	sector holding a changed word, and skip the others.
+//
+//	"file" is the place to write the bitmap to
+//----------------------------------------------------------------------
+
+void
+PersistentBitmap::WriteDirty(OpenFile *file)
+{
+    const int wordsPerSector = SectorSize / sizeof(unsigned);
+    int first, last;
+
+    for (first = 0; first < numWords; first += wordsPerSector) {
+	last = min(first + wordsPerSector, numWords);
+	for (int i = first; i < last; i++)
+	    if (map[i] != onDisk[i]) {
+		file->WriteAt((char *)&map[first], 
+			(last - first) * sizeof(unsigned), 
+			first * sizeof(unsigned));
+		bcopy((char *)&map[first], (char *)&onDisk[first], 
+			(last - first) * sizeof(unsigned));
+		break;
+	    }
+    }
+}
+
+//----------------------------------------------------------------------
+// PersistentBitmap::IsDirty
+// 	Return TRUE if the bitmap has changed since it was last read or
+//	written.
+//----------------------------------------------------------------------
+
+bool
+PersistentBitmap::IsDirty() const
+{
+    for (int i = 0; i < numWords; i++)
+	if (map[i] != onDisk[i])
+	    return TRUE;
+    return FALSE;
 }
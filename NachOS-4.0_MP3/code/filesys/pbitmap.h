@@ -20,6 +20,10 @@
 // The following class defines a persistent bitmap.  It inherits all
 // the behavior of a bitmap (see bitmap.h), adding the ability to
 // be read from and stored to the disk.
+//
+// It also remembers what the disk copy looks like, so that a bitmap
+// kept in memory for a long time can be flushed by writing only the
+// sectors whose words have changed.
 
 class PersistentBitmap : public Bitmap {
   public:
@@ -30,6 +34,11 @@ class PersistentBitmap : public Bitmap {
 
     void FetchFrom(OpenFile *file);     // read bitmap from the disk
     void WriteBack(OpenFile *file); 	// write bitmap contents to disk 
+    void WriteDirty(OpenFile *file);	// write only the changed sectors
+    bool IsDirty() const;		// changed since last read/written?
+
+  private:
+    unsigned int *onDisk;		// contents as last read or written
 };
 
 #endif // PBITMAP_H
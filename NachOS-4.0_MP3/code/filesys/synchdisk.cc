@@ -16,6 +16,10 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#ifndef FILESYS_STUB
+#include "journal.h"
+#include "lfs.h"
+#endif
 
 
 //----------------------------------------------------------------------
@@ -30,6 +34,8 @@ SynchDisk::SynchDisk()
     semaphore = new Semaphore("synch disk", 0);
     lock = new Lock("synch disk lock");
     disk = new Disk(this);
+    journal = NULL;
+    log = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -50,6 +56,10 @@ SynchDisk::~SynchDisk()
 // 	Read the contents of a disk sector into a buffer.  Return only
 //	after the data has been read.
 //
+//	If the file system is journaling, the newest copy of the sector
+//	may still be in the log rather than on disk.  If the disk is
+//	log-structured, the segment log knows where the sector really is.
+//
 //	"sectorNumber" -- the disk sector to read
 //	"data" -- the buffer to hold the contents of the disk sector
 //----------------------------------------------------------------------
@@ -57,10 +67,15 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+#ifndef FILESYS_STUB
+    if (journal != NULL && journal->Lookup(sectorNumber, data))
+	return;
+    if (log != NULL) {
+	log->ReadSector(sectorNumber, data);
+	return;
+    }
+#endif
+    ReadPhysical(sectorNumber, data);
 }
 
 //----------------------------------------------------------------------
@@ -68,12 +83,49 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 // 	Write the contents of a buffer into a disk sector.  Return only
 //	after the data has been written.
 //
+//	If the file system is journaling, the write may be captured by
+//	the log instead (cf. Journal::Absorb).  If the disk is
+//	log-structured, the write is appended to the current segment.
+//
 //	"sectorNumber" -- the disk sector to be written
 //	"data" -- the new contents of the disk sector
 //----------------------------------------------------------------------
 
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
+{
+#ifndef FILESYS_STUB
+    if (journal != NULL && journal->Absorb(sectorNumber, data))
+	return;
+    if (log != NULL) {
+	log->WriteSector(sectorNumber, data);
+	return;
+    }
+#endif
+    WritePhysical(sectorNumber, data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadPhysical/WritePhysical
+// 	Read/write a disk sector exactly where the caller says, bypassing
+//	any journal or segment log.  Return only after the data has been
+//	transferred.
+//
+//	"sectorNumber" -- the disk sector to read/write
+//	"data" -- the buffer to hold/the new contents of the disk sector
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadPhysical(int sectorNumber, char* data)
+{
+    lock->Acquire();			// only one disk I/O at a time
+    disk->ReadRequest(sectorNumber, data);
+    semaphore->P();			// wait for interrupt
+    lock->Release();
+}
+
+void
+SynchDisk::WritePhysical(int sectorNumber, char* data)
 {
     lock->Acquire();			// only one disk I/O at a time
     disk->WriteRequest(sectorNumber, data);
@@ -81,6 +133,23 @@ SynchDisk::WriteSector(int sectorNumber, char* data)
     lock->Release();
 }
 
+//----------------------------------------------------------------------
+// SynchDisk::Discard
+// 	The file system has freed a sector.  A plain disk doesn't care,
+//	but a log-structured one can stop keeping the old contents alive.
+//
+//	"sectorNumber" -- the disk sector that was freed
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Discard(int sectorNumber)
+{
+#ifndef FILESYS_STUB
+    if (log != NULL)
+	log->Discard(sectorNumber);
+#endif
+}
+
 //----------------------------------------------------------------------
 // SynchDisk::CallBack
 // 	Disk interrupt handler.  Wake up any thread waiting for the disk
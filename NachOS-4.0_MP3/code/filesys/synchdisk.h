@@ -15,6 +15,9 @@
 #include "synch.h"
 #include "callback.h"
 
+class Journal;
+class SegmentLog;
+
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
@@ -39,17 +42,36 @@ class SynchDisk : public CallBackObj {
     					// Disk::ReadRequest/WriteRequest and
 					// then wait until the request is done.
     void WriteSector(int sectorNumber, char* data);
+
+    void ReadPhysical(int sectorNumber, char* data);
+    void WritePhysical(int sectorNumber, char* data);
+					// The same, but always go straight
+					// to the disk; used by the layers
+					// below (journal, segment log)
+
+    void Discard(int sectorNumber);	// The file system no longer cares
+					// about the contents of a sector
     
     void CallBack();			// Called by the disk device interrupt
 					// handler, to signal that the
 					// current disk operation is complete.
 
+    void SetJournal(Journal *log) { journal = log; }
+					// Route sector reads and writes
+					// through a metadata log (cf. journal.h)
+    void SetLog(SegmentLog *segLog) { log = segLog; }
+					// Or through a log-structured
+					// layout (cf. lfs.h)
+
   private:
     Disk *disk;		  		// Raw disk device
     Semaphore *semaphore; 		// To synchronize requesting thread 
 					// with the interrupt handler
     Lock *lock;		  		// Only one read/write request
 					// can be sent to the disk at a time
+    Journal *journal;			// Metadata log, NULL if not journaling
+    SegmentLog *log;			// Segment log, NULL unless the disk is
+					// log-structured
 };
 
 #endif // SYNCHDISK_H
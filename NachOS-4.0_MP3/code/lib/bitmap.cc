@@ -20,18 +20,13 @@
 
 Bitmap::Bitmap(int numItems) 
 { 
-    int i;
-
     ASSERT(numItems > 0);
 
     numBits = numItems;
     numWords = divRoundUp(numBits, BitsInWord);
     map = new unsigned int[numWords];
-    for (i = 0; i < numWords; i++) {
-	map[i] = 0;		// initialize map to keep Purify happy
-    }
-    for (i = 0; i < numBits; i++) {
-        Clear(i);
+    for (int i = 0; i < numWords; i++) {
+	map[i] = 0;		// every bit clear
     }
 }
 
@@ -42,7 +37,7 @@ Bitmap::Bitmap(int numItems)
 
 Bitmap::~Bitmap()
 { 
-    delete map;
+    delete [] map;
 }
 
 //----------------------------------------------------------------------
@@ -98,27 +93,175 @@ Bitmap::Test(int which) const
     }
 }
 
+//----------------------------------------------------------------------
+// Bitmap::MarkRange
+// 	Set "count" bits in a row, a word at a time.
+//
+//	"first" is the number of the first bit to be set.
+//----------------------------------------------------------------------
+
+void
+Bitmap::MarkRange(int first, int count)
+{
+    int bit, n;
+
+    ASSERT(first >= 0 && count >= 0 && first + count <= numBits);
+
+    while (count > 0) {
+	bit = first % BitsInWord;
+	n = min(count, BitsInWord - bit);
+	if (n == BitsInWord) 
+	    map[first / BitsInWord] = ~0u;
+	else 
+	    map[first / BitsInWord] |= ((1u << n) - 1) << bit;
+	first += n;
+	count -= n;
+    }
+}
+
+//----------------------------------------------------------------------
+// Bitmap::LastWordMask
+// 	Return a mask of the bits of the last word that are part of the
+//	bitmap.  The rest are never set, but searches must not find them
+//	clear either.
+//----------------------------------------------------------------------
+
+unsigned int
+Bitmap::LastWordMask() const
+{
+    int used = numBits % BitsInWord;
+
+    return (used == 0) ? ~0u : (1u << used) - 1;
+}
+
+//----------------------------------------------------------------------
+// Bitmap::NextClear
+// 	Return the number of the first clear bit at or after "from", or
+//	numBits if there is none.  Whole words of set bits are passed 
+//	over at once, and the bit is picked out of its word by counting
+//	trailing zeroes.
+//----------------------------------------------------------------------
+
+int
+Bitmap::NextClear(int from) const
+{
+    int w;
+    unsigned int bits;
+
+    if (from >= numBits)
+	return numBits;
+    w = from / BitsInWord;
+    bits = ~map[w] & (~0u << (from % BitsInWord));
+    for (;;) {
+	if (w == numWords - 1)
+	    bits &= LastWordMask();
+	if (bits != 0)
+	    return w * BitsInWord + __builtin_ctz(bits);
+	if (++w == numWords)
+	    return numBits;
+	bits = ~map[w];
+    }
+}
+
+//----------------------------------------------------------------------
+// Bitmap::NextSet
+// 	Return the number of the first set bit at or after "from", or
+//	numBits if there is none.
+//----------------------------------------------------------------------
+
+int
+Bitmap::NextSet(int from) const
+{
+    int w;
+    unsigned int bits;
+
+    if (from >= numBits)
+	return numBits;
+    w = from / BitsInWord;
+    bits = map[w] & (~0u << (from % BitsInWord));
+    for (;;) {
+	if (bits != 0)
+	    return min(w * BitsInWord + __builtin_ctz(bits), numBits);
+	if (++w == numWords)
+	    return numBits;
+	bits = map[w];
+    }
+}
+
 //----------------------------------------------------------------------
 // Bitmap::FindAndSet
-// 	Return the number of the first bit which is clear.
+// 	Return the number of the first bit at or after "from" which is
+//	clear, wrapping around to the start if there is none after it.
 //	As a side effect, set the bit (mark it as in use).
 //	(In other words, find and allocate a bit.)
 //
+//	With "from" 0, this is first fit; passing one past the last bit
+//	allocated gives next fit, which keeps allocations together 
+//	without searching the full part of the map again every time.
+//
 //	If no bits are clear, return -1.
 //----------------------------------------------------------------------
 
 int 
-Bitmap::FindAndSet() 
+Bitmap::FindAndSet(int from) 
 {
-    for (int i = 0; i < numBits; i++) {
-	if (!Test(i)) {
-	    Mark(i);
-	    return i;
-	}
+    int which;
+
+    ASSERT(from >= 0);
+    if (from >= numBits)
+	from = 0;
+    which = NextClear(from);
+    if (which == numBits && from > 0)
+	which = NextClear(0);
+    if (which == numBits)
+	return -1;
+    Mark(which);
+    return which;
+}
+
+//----------------------------------------------------------------------
+// Bitmap::FindRange
+// 	Return the number of the first of "count" clear bits in a row,
+//	at or after "from", or -1 if there are none.  Each run of clear
+//	bits is found, and measured, a word at a time.
+//----------------------------------------------------------------------
+
+int
+Bitmap::FindRange(int count, int from) const
+{
+    int first, end;
+
+    for (first = NextClear(from); first < numBits; first = NextClear(end)) {
+	end = NextSet(first);
+	if (end - first >= count)
+	    return first;
     }
     return -1;
 }
 
+//----------------------------------------------------------------------
+// Bitmap::FindAndSetRange
+// 	Return the number of the first of "count" clear bits in a row,
+//	at or after "from" (or, failing that, from the start), and set
+//	them all.  A run does not wrap around the end of the bitmap.
+//
+//	If there is no such run, return -1.
+//----------------------------------------------------------------------
+
+int
+Bitmap::FindAndSetRange(int count, int from)
+{
+    int first;
+
+    ASSERT(count > 0 && from >= 0);
+    first = FindRange(count, from);
+    if (first < 0 && from > 0)
+	first = FindRange(count, 0);
+    if (first >= 0)
+	MarkRange(first, count);
+    return first;
+}
+
 //----------------------------------------------------------------------
 // Bitmap::NumClear
 // 	Return the number of clear bits in the bitmap.
@@ -130,12 +273,10 @@ Bitmap::NumClear() const
 {
     int count = 0;
 
-    for (int i = 0; i < numBits; i++) {
-	if (!Test(i)) {
-	    count++;
-	}
+    for (int i = 0; i < numWords - 1; i++) {
+	count += __builtin_popcount(~map[i]);
     }
-    return count;
+    return count + __builtin_popcount(~map[numWords - 1] & LastWordMask());
 }
 
 //----------------------------------------------------------------------
@@ -150,10 +291,8 @@ void
 Bitmap::Print() const
 {
     cout << "Bitmap set:\n"; 
-    for (int i = 0; i < numBits; i++) {
-	if (Test(i)) {
-	    cout << i << ", ";
-	}
+    for (int i = NextSet(0); i < numBits; i = NextSet(i + 1)) {
+	cout << i << ", ";
     }
     cout << "\n"; 
 }
@@ -185,6 +324,34 @@ Bitmap::SelfTest()
         Mark(i);
     }
     ASSERT(FindAndSet() == -1);		// bitmap should be full!
+    ASSERT(NumClear() == 0);
+    for (i = 0; i < numBits; i++) {
+        Clear(i);
+    }
+
+    // ranges, across words
+    ASSERT(FindAndSetRange(BitsInWord + 3) == 0);
+    ASSERT(NumClear() == numBits - BitsInWord - 3);
+    Clear(1);
+    Clear(2);
+    ASSERT(FindAndSetRange(3) == BitsInWord + 3);	// not in the hole
+    ASSERT(FindAndSetRange(2) == 1);
+    ASSERT(FindAndSetRange(numBits) == -1);
+
+    // next fit, wrapping around
+    ASSERT(FindAndSet(numBits - 1) == numBits - 1);
+    Clear(5);
+    ASSERT(FindAndSet(numBits - 1) == 5);
+    ASSERT(FindAndSet(6) == BitsInWord + 6);
+    for (i = 0; i < numBits; i++) {
+        Clear(i);
+    }
+
+    // a range running to the very end
+    MarkRange(0, numBits - 10);
+    ASSERT(FindAndSetRange(11) == -1);
+    ASSERT(FindAndSetRange(10, 1) == numBits - 10);
+    ASSERT(NumClear() == 0);
     for (i = 0; i < numBits; i++) {
         Clear(i);
     }
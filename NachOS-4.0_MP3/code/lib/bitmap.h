@@ -3,7 +3,9 @@
 //	can be either on or off.
 //
 //	Represented as an array of unsigned integers, on which we do
-//	modulo arithmetic to find the bit we are interested in.
+//	modulo arithmetic to find the bit we are interested in.  Searches
+//	look at a word at a time, so finding a clear bit costs one step
+//	per word passed over, not one per bit.
 //
 //	The bitmap can be parameterized with with the number of bits being 
 //	managed.
@@ -39,9 +41,16 @@ class Bitmap {
     void Mark(int which);   	// Set the "nth" bit
     void Clear(int which);  	// Clear the "nth" bit
     bool Test(int which) const;	// Is the "nth" bit set?
-    int FindAndSet();         // Return the # of a clear bit, and as a side
-				// effect, set the bit. 
+    int FindAndSet(int from = 0);
+				// Return the # of the first clear bit at
+				// or after "from" (wrapping around), and 
+				// as a side effect, set the bit. 
 				// If no bits are clear, return -1.
+    int FindAndSetRange(int count, int from = 0);
+				// Same, but for "count" clear bits in a 
+				// row; return the # of the first
+    void MarkRange(int first, int count);
+				// Set "count" bits from "first" on
     int NumClear() const;	// Return the number of clear bits
 
     void Print() const;		// Print contents of bitmap
@@ -54,6 +63,18 @@ class Bitmap {
 				//  multiple of the number of bits in
 				//  a word)
     unsigned int *map;		// bit storage
+
+  private:
+    unsigned int LastWordMask() const;
+				// the bits of the last word in use
+    int NextClear(int from) const;
+				// # of the first clear bit at or after
+				// "from", or numBits if none
+    int NextSet(int from) const;
+				// same, for a set bit
+    int FindRange(int count, int from) const;
+				// first of "count" clear bits in a row
+				// at or after "from", or -1
 };
 
 #endif // BITMAP_H
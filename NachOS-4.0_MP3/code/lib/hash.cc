@@ -1,11 +1,12 @@
 // hash.cc 
 //     	Routines to manage a self-expanding hash table of arbitrary things.
 //	The hashing function is supplied by the objects being put into
-//	the table; we use chaining to resolve hash conflicts.
+//	the table; we use open addressing, with linear probing, to
+//	resolve hash conflicts.
 //
-//	The hash table is implemented as an array of sorted lists,
-//	and we expand the hash table if the number of elements in the table
-//	gets too big.
+//	The hash table is implemented as an array of slots, and we move
+//	the items to a larger array, a few at a time, if the number of
+//	elements in the table gets too big.
 // 
 //     	NOTE: Mutual exclusion must be provided by the caller.
 //
@@ -13,12 +14,76 @@
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
 
-const int InitialBuckets = 4;	// how big a hash table do we start with
-const int ResizeRatio = 3;	// when do we grow the hash table?
-const int IncreaseSizeBy = 4;	// how much do we grow table when needed?
+const int InitialSlots = 16;	// how big a hash table do we start with
+				// (at least HashGroup)
+const int MaxLoadEighths = 7;	// grow the table when it is 7/8 full
+const int IncreaseSizeBy = 2;	// how much do we grow table when needed?
+const int MoveSlots = 8;	// # of old slots looked at, per insert
+				// or remove, while growing
 
 #include "copyright.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>		// to compare a group of control bytes
+#endif
+
+//----------------------------------------------------------------------
+// HashSlots<T>::HashSlots
+//	Initialize an array of "sz" empty slots.  "sz" must be a power of
+//	two, so that a hash value can be reduced to a slot with a mask.
+//----------------------------------------------------------------------
+
+template <class T>
+HashSlots<T>::HashSlots(int sz)
+{
+    ASSERT(sz >= HashGroup && (sz & (sz - 1)) == 0);
+    size = sz;
+    mask = sz - 1;
+    control = new unsigned char[size + HashGroup];
+    for (int i = 0; i < size + HashGroup; i++)
+	control[i] = HashEmpty;
+    distance = new unsigned char[size];
+    items = new T[size];
+}
+
+//----------------------------------------------------------------------
+// HashSlots<T>::~HashSlots
+//	De-allocate the slots (but not the items in them).
+//----------------------------------------------------------------------
+
+template <class T>
+HashSlots<T>::~HashSlots()
+{
+    delete [] control;
+    delete [] distance;
+    delete [] items;
+}
+
+//----------------------------------------------------------------------
+// HashSlots<T>::Match
+//	Return a bitmap of which of the HashGroup slots starting at
+//	"slot" have control byte "c": bit i for slot + i (wrapping
+//	around at the end).  With SSE2, this is three instructions.
+//----------------------------------------------------------------------
+
+template <class T>
+unsigned int
+HashSlots<T>::Match(int slot, unsigned char c) const
+{
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((const __m128i *) (control + slot));
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char) c)));
+#else
+    unsigned int bits = 0;
+
+    for (int i = 0; i < HashGroup; i++)
+	if (control[slot + i] == c)
+	    bits |= 1 << i;
+    return bits;
+#endif
+}
+
 //----------------------------------------------------------------------
 // HashTable<Key,T>::HashTable
 //	Initialize a hash table, empty to start with.
@@ -29,79 +94,191 @@ template <class Key, class T>
 HashTable<Key,T>::HashTable(Key (*get)(T x), unsigned (*hFunc)(Key x))
 { 
     numItems = 0;
-    InitBuckets(InitialBuckets);
+    slots = new HashSlots<T>(InitialSlots);
+    oldSlots = NULL;
+    nextToMove = 0;
     getKey = get;
     hash = hFunc;
 }
 
 //----------------------------------------------------------------------
-// HashTable<Key,T>::InitBuckets
-//	Initialize the bucket array for a hash table.
-//	Called by the constructor and by ReHash().
+// HashTable<T>::~HashTable
+//	Prepare a hash table for deallocation.  
 //----------------------------------------------------------------------
 
 template <class Key, class T>
-void
-HashTable<Key,T>::InitBuckets(int sz)
+HashTable<Key,T>::~HashTable()
 { 
-    numBuckets = sz;
-    buckets = new Bucket[numBuckets];
-    for (int i = 0; i < sz; i++) {
-    	buckets[i] = new List<T>;
+    ASSERT(IsEmpty());		// make sure table is empty
+    delete slots;
+    if (oldSlots != NULL)
+	delete oldSlots;
+}
+
+//----------------------------------------------------------------------
+// HashTable<Key,T>::HashValue
+//      Return the hash of "key", with its bits mixed (as at the end of
+//	MurmurHash3), since we use both the low bits (for the home slot)
+//	and the high bits (for the control byte), and hash functions
+//	like "return key" leave the high bits 0.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+unsigned int
+HashTable<Key, T>::HashValue(Key key) const
+{
+    unsigned int h = (*hash)(key);
+
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+    return h;
+}
+
+//----------------------------------------------------------------------
+// HashTable<Key,T>::FindSlot
+//      Find the slot of "array" holding the item with "key", whose
+//	hash is "h".  The item, if there, is between its home slot and
+//	the first empty slot after it, so look at the slots from home,
+//	a group at a time, comparing keys only where the control byte
+//	matches, until a group has an empty slot.  (Slots whose items
+//	have moved, in an old array, don't stop the search.)
+//
+// Returns:
+//	The slot, or -1 if the item is not in "array".
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+int
+HashTable<Key,T>::FindSlot(HashSlots<T> *array, Key key, unsigned int h) const
+{
+    int slot = h & array->mask, found;
+    unsigned int match, empty;
+
+    for (;;) {			// there is always an empty slot
+	match = array->Match(slot, h >> 25);
+	empty = array->Match(slot, HashEmpty);
+	if (empty != 0)
+	    match &= (empty & -empty) - 1;	// only those before it
+	while (match != 0) {
+	    found = (slot + __builtin_ffs(match) - 1) & array->mask;
+	    if (key == getKey(array->items[found]))
+		return found;
+	    match &= match - 1;
+	}
+	if (empty != 0)
+	    return -1;
+	slot = (slot + HashGroup) & array->mask;
     }
 }
 
 //----------------------------------------------------------------------
-// HashTable<T>::~HashTable
-//	Prepare a hash table for deallocation.  
+// HashTable<Key,T>::Place
+//      Put "item", whose hash is "h", in the first empty slot from its
+//	home, Robin Hood style: on the way, it takes the slot of any
+//	item closer to home than it is, and that item goes on looking
+//	instead.
 //----------------------------------------------------------------------
 
 template <class Key, class T>
-HashTable<Key,T>::~HashTable()
+void
+HashTable<Key,T>::Place(HashSlots<T> *array, T item, unsigned int h)
 { 
-    ASSERT(IsEmpty());		// make sure table is empty
-    DeleteBuckets(buckets, numBuckets);
+    int slot = h & array->mask;
+    unsigned char c = h >> 25, swapC;
+    int distance = 0, swapDistance;
+    T swapItem;
+
+    for (;;) {
+	if (array->control[slot] == HashEmpty) {
+	    array->items[slot] = item;
+	    array->distance[slot] = distance;
+	    array->SetControl(slot, c);
+	    return;
+    }
+	ASSERT(array->control[slot] != HashMoved);	// not an old array
+	if (array->distance[slot] < distance) {		// take its place
+	    swapItem = array->items[slot];
+	    swapDistance = array->distance[slot];
+	    swapC = array->control[slot];
+	    array->items[slot] = item;
+	    array->distance[slot] = distance;
+	    array->SetControl(slot, c);
+	    item = swapItem;
+	    distance = swapDistance;
+	    c = swapC;
+	}
+	slot = (slot + 1) & array->mask;
+	distance++;
+	ASSERT(distance < 256);
+    }
 }
 
 //----------------------------------------------------------------------
-// HashTable<Key,T>::DeleteBuckets
-//	De-Initialize the bucket array for a hash table.
-//	Called by the destructor and by ReHash().
+// HashTable<Key,T>::Delete
+//      Take the item out of "slot" of the current array.  Items after
+//	it that are not in their home slot move back one, so no item
+//	is separated from its home by an empty slot, and no marker is
+//	needed where the item was.
 //----------------------------------------------------------------------
 
 template <class Key, class T>
 void
-HashTable<Key,T>::DeleteBuckets(List<T> **table, int sz)
-{ 
-    for (int i = 0; i < sz; i++) {
-    	delete table[i];
+HashTable<Key,T>::Delete(HashSlots<T> *array, int slot)
+{
+    int next = (slot + 1) & array->mask;
+
+    while (array->control[next] != HashEmpty && array->distance[next] > 0) {
+	array->items[slot] = array->items[next];
+	array->distance[slot] = array->distance[next] - 1;
+	array->SetControl(slot, array->control[next]);
+	slot = next;
+	next = (next + 1) & array->mask;
     }
-    delete [] table;
+    array->SetControl(slot, HashEmpty);
 }
 
 //----------------------------------------------------------------------
-// HashTable<Key,T>::HashValue
-//      Return hash table bucket that would contain key.
+// HashTable<Key,T>::MoveSome
+//      If the table is growing, move the items in the next MoveSlots
+//	slots of the old array to the new one, and mark them moved.
+//	When all have been moved, get rid of the old array.
 //----------------------------------------------------------------------
 
 template <class Key, class T>
-int
-HashTable<Key, T>::HashValue(Key key) const 
+void
+HashTable<Key,T>::MoveSome()
 {
-    int result = (*hash)(key) % numBuckets;
-    ASSERT(result >= 0 && result < numBuckets);
-    return result;
+    unsigned char c;
+    T item;
+
+    if (oldSlots == NULL)
+	return;
+    for (int i = 0; i < MoveSlots && nextToMove < oldSlots->size;
+						i++, nextToMove++) {
+	c = oldSlots->control[nextToMove];
+	if (c != HashEmpty && c != HashMoved) {
+	    item = oldSlots->items[nextToMove];
+	    Place(slots, item, HashValue(getKey(item)));
+	    oldSlots->SetControl(nextToMove, HashMoved);
+	}
+    }
+    if (nextToMove == oldSlots->size) {
+	delete oldSlots;
+	oldSlots = NULL;
+    }
 }
 
 //----------------------------------------------------------------------
 // HashTable<Key,T>::Insert
 //      Put an item into the hashtable.
 //      
-//	Resize the table if the # of elements / # of buckets is too big.
-//	Then allocate a HashElement to keep track of the key, item pair,
-//	and add it to the right bucket.
+//	If the table is too full, start moving the items to a larger
+//	array.  Either way, put the item in the current array, and move
+//	a few more.
 //
-//	"key" is the key we'll use to find this item.
 //	"item" is the thing to put in the table.
 //----------------------------------------------------------------------
 
@@ -113,51 +290,26 @@ HashTable<Key,T>::Insert(T item)
 
     ASSERT(!IsInTable(key));
 
-    if ((numItems / numBuckets) >= ResizeRatio) {
-	ReHash();
+    if (oldSlots == NULL
+		&& (numItems + 1) * 8 > slots->size * MaxLoadEighths) {
+	oldSlots = slots;
+	slots = new HashSlots<T>(oldSlots->size * IncreaseSizeBy);
+	nextToMove = 0;
     }
+    ASSERT((numItems + 1) * 8 <= slots->size * MaxLoadEighths
+						|| oldSlots != NULL);
 
-    buckets[HashValue(key)]->Append(item);
+    Place(slots, item, HashValue(key));
     numItems++;
+    MoveSome();
 
     ASSERT(IsInTable(key));
 }
 
 //----------------------------------------------------------------------
-// HashTable<Key,T>::ReHash
-//      Increase the size of the hashtable, by 
-//	  (i) making a new table
-//	  (ii) moving all the elements into the new table
-//	  (iii) deleting the old table
-//----------------------------------------------------------------------
-
-template <class Key, class T>
-void
-HashTable<Key,T>::ReHash()
-{
-    Bucket *oldTable = buckets;
-    int oldSize = numBuckets;
-    T item;
-
-    SanityCheck();
-    InitBuckets(numBuckets * IncreaseSizeBy);
-
-    for (int i = 0; i < oldSize; i++) {
-	while (!oldTable[i]->IsEmpty()) {
-	    item = oldTable[i]->RemoveFront();
-	    buckets[HashValue(getKey(item))]->Append(item);
-        }
-    }
-    DeleteBuckets(oldTable, oldSize);
-    SanityCheck();
-}
-
-//----------------------------------------------------------------------
-// HashTable<Key,T>::FindInBucket
-//      Find an item in a hash table bucket, from it's key
-//
-//	"bucket" -- the list storing the item, if it's in the table 
-//	"key" -- the key uniquely identifying the item
+// HashTable<Key,T>::Find
+//      Find an item from the hash table: in the current array, or if
+//	the table is growing, in the old one.
 // 
 // Returns:
 //	Whether item is found, and if found, the item.
@@ -165,14 +317,19 @@ HashTable<Key,T>::ReHash()
 
 template <class Key, class T>
 bool
-HashTable<Key,T>::FindInBucket(int bucket, 
-				Key key, T *itemPtr) const
+HashTable<Key,T>::Find(Key key, T *itemPtr) const
 {
-    ListIterator<T> iterator(buckets[bucket]);
+    unsigned int h = HashValue(key);
+    int slot = FindSlot(slots, key, h);
 
-    for (; !iterator.IsDone(); iterator.Next()) {
-	if (key == getKey(iterator.Item())) { // found!
-	    *itemPtr = iterator.Item();
+    if (slot >= 0) {
+	*itemPtr = slots->items[slot];
+	return TRUE;
+    }
+    if (oldSlots != NULL) {
+	slot = FindSlot(oldSlots, key, h);
+	if (slot >= 0) {
+	    *itemPtr = oldSlots->items[slot];
 	    return TRUE;
         }
     }
@@ -180,26 +337,10 @@ HashTable<Key,T>::FindInBucket(int bucket,
     return FALSE;
 }
 
-//----------------------------------------------------------------------
-// HashTable<Key,T>::Find
-//      Find an item from the hash table.
-// 
-// Returns:
-//	The item or NULL if not found. 
-//----------------------------------------------------------------------
-
-template <class Key, class T>
-bool
-HashTable<Key,T>::Find(Key key, T *itemPtr) const
-{
-    int bucket = HashValue(key);
-    
-    return FindInBucket(bucket, key, itemPtr); 
-}
-
 //----------------------------------------------------------------------
 // HashTable<Key,T>::Remove
 //      Remove an item from the hash table. The item must be in the table.
+//	An item still in the old array is just marked moved.
 // 
 // Returns:
 //	The removed item.
@@ -209,20 +350,27 @@ template <class Key, class T>
 T
 HashTable<Key,T>::Remove(Key key)
 {
-    int bucket = HashValue(key);
+    unsigned int h = HashValue(key);
+    int slot = FindSlot(slots, key, h);
     T item;
-    bool found = FindInBucket(bucket, key, &item); 
 
-    ASSERT(found);	// item must be in table
-
-    buckets[bucket]->Remove(item);
+    if (slot >= 0) {
+	item = slots->items[slot];
+	Delete(slots, slot);
+    } else {
+	ASSERT(oldSlots != NULL);	// item must be in table
+	slot = FindSlot(oldSlots, key, h);
+	ASSERT(slot >= 0);
+	item = oldSlots->items[slot];
+	oldSlots->SetControl(slot, HashMoved);
+    }
     numItems--;
+    MoveSome();
 
     ASSERT(!IsInTable(key));
     return item;
 }
 
-
 //----------------------------------------------------------------------
 // HashTable<Key,T>::Apply
 //      Apply function to every item in the hash table.
@@ -234,57 +382,55 @@ template <class Key,class T>
 void
 HashTable<Key,T>::Apply(void (*func)(T)) const
 {
-    for (int bucket = 0; bucket < numBuckets; bucket++) {
-        buckets[bucket]->Apply(func);
-    }
-}
-
-//----------------------------------------------------------------------
-// HashTable<Key,T>::FindNextFullBucket
-//      Find the next bucket in the hash table that has any items in it.
-//
-//	"bucket" -- where to start looking for full buckets
-//----------------------------------------------------------------------
-
-template <class Key,class T>
-int
-HashTable<Key,T>::FindNextFullBucket(int bucket) const
-{ 
-    for (; bucket < numBuckets; bucket++) {
-	if (!buckets[bucket]->IsEmpty()) {
-	     break;
-	}
+    for (int i = 0; i < slots->size; i++)
+	if (!(slots->control[i] & HashEmpty))	// high bit clear: an item
+	    (*func)(slots->items[i]);
+    if (oldSlots != NULL) {
+	for (int i = 0; i < oldSlots->size; i++)
+	    if (!(oldSlots->control[i] & HashEmpty))
+		(*func)(oldSlots->items[i]);
     }
-    return bucket;
 }
 
 //----------------------------------------------------------------------
 // HashTable<Key,T>::SanityCheck
 //      Test whether this is still a legal hash table.
 //
-//	Tests: are all the buckets legal?
+//	Tests: are the copies of the control bytes right?
+//	       does each control byte match its item's hash?
+//	       is each item where a lookup would find it, as far from
+//	       home as its slot says?
 //	       does the table have the right # of elements?
-//	       do all the elements hash to where they are stored?
 //----------------------------------------------------------------------
 
 template <class Key, class T>
 void 
 HashTable<Key,T>::SanityCheck() const
 {
+    HashSlots<T> *array;
     int numFound = 0;
-    ListIterator<T> *iterator;
-
-    for (int i = 0; i < numBuckets; i++) {
-	buckets[i]->SanityCheck();
-	numFound += buckets[i]->NumInList();
-	iterator = new ListIterator<T>(buckets[i]);
-        for (; !iterator->IsDone(); iterator->Next()) {
-	    ASSERT(i == HashValue(getKey(iterator->Item())));
+    unsigned int h;
+
+    for (int a = 0; a < 2; a++) {
+	array = (a == 0) ? slots : oldSlots;
+	if (array == NULL)
+	    continue;
+	for (int i = 0; i < HashGroup; i++) {
+	    ASSERT(array->control[array->size + i] == array->control[i]);
         }
-        delete iterator;
+	for (int i = 0; i < array->size; i++) {
+	    if (array->control[i] & HashEmpty)
+		continue;
+	    numFound++;
+	    h = HashValue(getKey(array->items[i]));
+	    ASSERT(array->control[i] == (h >> 25));
+	    ASSERT(FindSlot(array, getKey(array->items[i]), h) == i);
+	    if (array == slots) {
+		ASSERT(array->distance[i] == ((i - h) & array->mask));
+	    }
+	}
     }
     ASSERT(numItems == numFound);
-
 }
 
 //----------------------------------------------------------------------
@@ -297,6 +443,7 @@ void
 HashTable<Key,T>::SelfTest(T *p, int numEntries)
 {
     int i;
+    HashTable<Key,T> *table;
     HashIterator<Key, T> *iterator = new HashIterator<Key,T>(this);
     
     SanityCheck();
@@ -311,6 +458,14 @@ HashTable<Key,T>::SelfTest(T *p, int numEntries)
         ASSERT(IsInTable(getKey(p[i])));
         ASSERT(!IsEmpty());
     }
+    SanityCheck();
+
+    // should be able to step through everything we put in
+    iterator = new HashIterator<Key,T>(this);
+    for (i = 0; !iterator->IsDone(); iterator->Next())
+	i++;
+    ASSERT(i == numEntries);
+    delete iterator;
     
     // should be able to get out everything we put in
     for (i = 0; i < numEntries; i++) {  
@@ -319,6 +474,61 @@ HashTable<Key,T>::SelfTest(T *p, int numEntries)
 
     ASSERT(IsEmpty());
     SanityCheck();
+
+    // again, a step at a time, in a table starting out small
+    table = new HashTable<Key,T>(getKey, hash);
+    table->GrowTest(p, numEntries);
+    delete table;
+}
+
+//----------------------------------------------------------------------
+// HashTable<Key,T>::GrowTest
+//      Put items into an empty table and take them out again, as in
+//	SelfTest, but checking the table after every step, and testing
+//	the cases that only come up as it grows.
+//----------------------------------------------------------------------
+
+template <class Key, class T>
+void
+HashTable<Key,T>::GrowTest(T *p, int numEntries)
+{
+    int i, j;
+    T item, found;
+
+    // While the table grows, find and remove an item not yet moved
+    // out of the old array.  When the last slot is full, and the item
+    // in slot 0 has wrapped around to get there, remove the last item,
+    // so that slot 0 is shifted back across the end.
+    for (i = 0; i < numEntries; i++) {
+        Insert(p[i]);
+	SanityCheck();
+	if (oldSlots != NULL) {
+	    for (j = nextToMove; j < oldSlots->size; j++)
+		if (!(oldSlots->control[j] & HashEmpty))
+		    break;
+	    if (j < oldSlots->size) {
+		item = oldSlots->items[j];
+		ASSERT(Find(getKey(item), &found) && found == item);
+		ASSERT(Remove(getKey(item)) == item);
+		SanityCheck();
+		Insert(item);
+		SanityCheck();
+	    }
+	}
+	if (!(slots->control[slots->mask] & HashEmpty)
+		&& !(slots->control[0] & HashEmpty) && slots->distance[0] > 0) {
+	    item = slots->items[slots->mask];
+	    ASSERT(Remove(getKey(item)) == item);
+	    SanityCheck();
+	    Insert(item);
+	    SanityCheck();
+	}
+    }
+    for (i = numEntries - 1; i >= 0; i--) {	// out in the other order
+        ASSERT(Remove(getKey(p[i])) == p[i]);
+	SanityCheck();
+    }
+    ASSERT(IsEmpty());
 }
 
 
@@ -332,10 +542,28 @@ template <class Key, class T>
 HashIterator<Key,T>::HashIterator(HashTable<Key,T> *tbl) 
 { 
     table = tbl;
-    bucket = table->FindNextFullBucket(0);
-    bucketIter = NULL;
-    if (bucket < table->numBuckets) {
-	bucketIter = new ListIterator<T>(table->buckets[bucket]);
+    array = table->slots;
+    slot = 0;
+    SkipEmpty();
+}
+
+//----------------------------------------------------------------------
+// HashIterator<Key,T>::SkipEmpty
+//      Move on from the current slot to the first one with an item:
+//	in the current array, then in the old array, if the table is
+//	growing.  If there are no more, we are done.
+//----------------------------------------------------------------------
+
+template <class Key,class T>
+void
+HashIterator<Key,T>::SkipEmpty()
+{
+    while (array != NULL) {
+	for (; slot < array->size; slot++)
+	    if (!(array->control[slot] & HashEmpty))
+		return;
+	array = (array == table->slots) ? table->oldSlots : NULL;
+	slot = 0;
     }
 }
 
@@ -348,13 +576,6 @@ template <class Key,class T>
 void
 HashIterator<Key,T>::Next() 
 { 
-    bucketIter->Next();
-    if (bucketIter->IsDone()) {
-	delete bucketIter;
-	bucketIter = NULL;
-        bucket = table->FindNextFullBucket(++bucket);
-        if (bucket < table->numBuckets) {
-	    bucketIter = new ListIterator<T>(table->buckets[bucket]);
-        }
-    }
+    slot++;
+    SkipEmpty();
 }
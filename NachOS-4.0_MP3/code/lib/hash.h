@@ -16,8 +16,10 @@
 //		Key GetKey(T x);
 //
 //	The hash table automatically resizes itself as items are
-//	put into the table.  The implementation uses chaining
-//	to resolve hash conflicts.
+//	put into the table.  The implementation uses open addressing:
+//	items are kept in one array of slots, and an item that
+//	collides goes in the next free slot (linear probing).  There is
+//	no memory allocated per item.
 //
 //	Allocation and deallocation of the items in the table are to 
 //	be done by the caller.
@@ -32,9 +34,57 @@
 #include "copyright.h"
 #include "list.h"
 
+#define HashGroup	16	// # of slots probed at once
+
+// The following class defines one array of slots for a hash table.
+// Each slot has a "control byte": HashEmpty or HashMoved (high bit
+// set), or, if the slot has an item, 7 bits of the item's hash.  A
+// lookup compares the control bytes of HashGroup slots at once (with
+// SSE2, if the host has it), and only looks at the items whose bits
+// match.  The first HashGroup control bytes are repeated at the end,
+// so a group starting near the end wraps around.
+
+const unsigned char HashEmpty = 0x80;	// the slot never had an item,
+					// or it was removed
+const unsigned char HashMoved = 0xfe;	// the item has moved to the new
+					// array (during a resize)
+
+template <class T>
+class HashSlots {
+  public:
+    HashSlots(int size);	// make "size" empty slots (a power of 2)
+    ~HashSlots();
+
+    int size;			// # of slots
+    unsigned int mask;		// size - 1
+    unsigned char *control;	// control byte of each slot
+    unsigned char *distance;	// how far each item is from its home
+    T *items;			// the items
+
+    void SetControl(int slot, unsigned char c) {	// keep the copy
+	control[slot] = c;				// at the end
+	if (slot < HashGroup)
+	    control[size + slot] = c;
+    }
+    unsigned int Match(int slot, unsigned char c) const;
+				// bit i set if the control byte of
+				// slot + i is "c", for i < HashGroup
+};
+
 // The following class defines a "hash table" -- allowing quick
 // lookup according to the hash function defined for the items
 // being put into the table.
+//
+// Items are placed "Robin Hood" style: an item being put in takes
+// the slot of any item closer to its home slot than it is, and that
+// item moves on instead.  This keeps every item close to its home.
+// Removing an item pulls the items after it back a slot, so removed
+// items leave no trace.
+//
+// When the table gets 7/8 full, it starts moving the items into a
+// new array twice as large, a few slots each time an item is put in
+// or removed -- so no single operation has to move them all.  Until
+// the old array is empty, lookups check both.
 
 template <class Key,class T> class HashIterator;
 
@@ -64,28 +114,26 @@ class HashTable {
     				// is the module working?
 
   private:
-typedef List<T> *Bucket;
-
-    Bucket *buckets;		// the array of hash buckets
-    int numBuckets;		// the number of buckets
+    HashSlots<T> *slots;	// where items go
+    HashSlots<T> *oldSlots;	// while resizing, the array whose items
+				// are being moved into "slots"; or NULL
+    int nextToMove;		// the next slot of "oldSlots" to move
     int numItems;		// the number of items in the table
     
     Key (*getKey)(T x);		// get Key from value
     unsigned (*hash)(Key x);	// the hash function
 
-    void InitBuckets(int size);// initialize bucket array
-    void DeleteBuckets(Bucket *table, int size);
-    				// deallocate bucket array
-				
-    int HashValue(Key key) const;
-    				// which bucket does the key hash to?
-
-    void ReHash();		// expand the hash table
-    
-    bool FindInBucket(int bucket, Key key, T *itemPtr) const; 
-    				// find item in bucket
-    int FindNextFullBucket(int start) const;
-    				// find next full bucket starting from this one
+    unsigned int HashValue(Key key) const;
+    				// the hash function, well mixed
+    int FindSlot(HashSlots<T> *array, Key key, unsigned int h) const;
+    				// the slot of "array" with "key", or -1
+    void Place(HashSlots<T> *array, T item, unsigned int h);
+    				// put an item in "array"
+    void Delete(HashSlots<T> *array, int slot);
+    				// take the item out of "array"
+    void MoveSome();		// continue resizing
+    void GrowTest(T *p, int numItems);
+				// SelfTest, a step at a time
 
     friend class HashIterator<Key,T>;
 };
@@ -102,19 +150,19 @@ template <class Key,class T>
 class HashIterator {
   public:
     HashIterator(HashTable<Key,T> *table); // initialize an iterator
-    ~HashIterator() { if (bucketIter != NULL) delete bucketIter;}; 
-				// destruct an iterator
 
-    bool IsDone() { return (bucket == table->numBuckets); };
+    bool IsDone() { return (array == NULL); };
 				// return TRUE if no more items in table 
-    T Item() { ASSERT(!IsDone()); return bucketIter->Item(); }; 
+    T Item() { ASSERT(!IsDone()); return array->items[slot]; };
 				// return current item in table
     void Next(); 		// update iterator to point to next
 
   private:   
     HashTable<Key,T> *table;	// the hash table we're stepping through
-    int bucket;			// current bucket we are in
-    ListIterator<T> *bucketIter; // where we are in the bucket
+    HashSlots<T> *array;	// the array we are in, NULL when done
+    int slot;			// current slot in it
+
+    void SkipEmpty();		// move on to a slot with an item
 };
 
 #include "hash.cc"		// templates are really like macros
@@ -1,6 +1,7 @@
 // libtest.cc 
 //	Driver code to call self-test routines for standard library
-//	classes -- bitmaps, lists, sorted lists, and hash tables.
+//	classes -- bitmaps, lists, sorted lists, and hash tables --
+//	and to time sorted lists against skip lists.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -58,6 +59,12 @@ static int listTestVector[] = { 9, 5, 7 };
 static char *hashTestVector[] = { "0", "1", "2", "3", "4", "5", "6",
 	 "7", "8", "9", "10", "11", "12", "13", "14"};
 
+// And a larger set, made up by LibSelfTest, to test the HashTable as it
+// grows through several sizes
+#define HashBigTest	500
+static char hashBigNames[HashBigTest][4];
+static char *hashBigVector[HashBigTest];
+
 //----------------------------------------------------------------------
 // LibSelfTest
 //	Run self tests on bitmaps, lists, sorted lists, and 
@@ -69,6 +76,7 @@ LibSelfTest () {
     Bitmap *map = new Bitmap(200);
     List<int> *list = new List<int>;
     SortedList<int> *sortList = new SortedList<int>(IntCompare);
+    SkipList<int> *skipList = new SkipList<int>(IntCompare);
     HashTable<int, char *> *hashTable = 
 	new HashTable<int, char *>(HashKey, HashInt);
 	
@@ -76,10 +84,106 @@ LibSelfTest () {
     map->SelfTest();
     list->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     sortList->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
+    skipList->SelfTest(listTestVector, sizeof(listTestVector)/sizeof(int));
     hashTable->SelfTest(hashTestVector, sizeof(hashTestVector)/sizeof(char *));
+    for (int i = 0; i < HashBigTest; i++) {
+	sprintf(hashBigNames[i], "%d", i);
+	hashBigVector[i] = hashBigNames[i];
+    }
+    hashTable->SelfTest(hashBigVector, HashBigTest);
 
     delete map;
     delete list;
     delete sortList;
+    delete skipList;
     delete hashTable;
 }
+
+// Sizes of the lists timed by LibBenchmark
+static int benchSizes[] = { 10, 1000, 100000 };
+
+#define BenchHolds	1000	// # of hold operations timed
+#define BenchStart	1000	// items start at times in [0, BenchStart)
+#define BenchGap	100	// and move on by up to BenchGap
+
+//----------------------------------------------------------------------
+// BenchRandom
+//	Return a pseudo-random number, from a xorshift generator, so
+//	that both kinds of list are timed on the same items.
+//----------------------------------------------------------------------
+
+static unsigned int
+BenchRandom(unsigned int *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+//----------------------------------------------------------------------
+// TimeList
+//	Time a sorted list of "n" items, used as an event queue, and 
+//	print the time per operation, in microseconds.  Each item is an
+//	event, for one of "n" objects, at some time; the items are 
+//	"time * n + object", so that no two are equal.
+//
+//	First the list is filled, in random order.  Then it is "held":
+//	the first event is taken off, and its object's next event put
+//	on, a little later.  This is what the interrupt queue does, and
+//	the classic test of an event queue.  Then the list is emptied.
+//
+//	"name" -- what kind of list it is
+//	"list" -- the list, empty; it is left empty
+//----------------------------------------------------------------------
+
+template <class L>
+static void
+TimeList(const char *name, L *list, int n)
+{
+    unsigned int state = 1;
+    double start, fill, hold, empty;
+    int item;
+
+    start = HostTime();
+    for (int i = 0; i < n; i++)
+	list->Insert((BenchRandom(&state) % BenchStart) * n + i);
+    fill = HostTime();
+    for (int i = 0; i < BenchHolds; i++) {
+	item = list->RemoveFront();
+	list->Insert((item / n + 1 + BenchRandom(&state) % BenchGap) * n 
+							+ item % n);
+    }
+    hold = HostTime();
+    while (!list->IsEmpty())
+	(void) list->RemoveFront();
+    empty = HostTime();
+
+    cout << name << " of " << n << ": insert " 
+	 << (fill - start) * 1e6 / n << ", hold " 
+	 << (hold - fill) * 1e6 / BenchHolds << ", remove " 
+	 << (empty - hold) * 1e6 / n << " usec per operation\n";
+}
+
+//----------------------------------------------------------------------
+// LibBenchmark
+//	Time sorted lists against skip lists, of each size in 
+//	benchSizes.  (Filling a sorted list of 100000 takes a minute or
+//	so, most of it checking that each item is not already there.)
+//----------------------------------------------------------------------
+
+void
+LibBenchmark()
+{
+    SortedList<int> *sortList;
+    SkipList<int> *skipList;
+
+    for (unsigned int i = 0; i < sizeof(benchSizes)/sizeof(int); i++) {
+	sortList = new SortedList<int>(IntCompare);
+	skipList = new SkipList<int>(IntCompare);
+	TimeList("SortedList", sortList, benchSizes[i]);
+	TimeList("SkipList", skipList, benchSizes[i]);
+	delete sortList;
+	delete skipList;
+    }
+}
@@ -11,5 +11,6 @@
 #include "copyright.h"
 
 extern void LibSelfTest();
+extern void LibBenchmark();	// time SortedList against SkipList
 
 #endif // LIBTEST_H
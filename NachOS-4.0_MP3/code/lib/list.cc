@@ -6,7 +6,9 @@
 // 	A "ListElement" is allocated for each item to be put on the
 //	list; it is de-allocated when the item is removed. This means
 //      we don't need to keep a "next" pointer in every object we
-//      want to put on a list.
+//      want to put on a list.  (ListElements are kept on a FreeList,
+//	so this is cheap.  An IntrusiveList does keep a "next" pointer
+//	in every object, and needs no allocation at all.)
 // 
 //     	NOTE: Mutual exclusion must be provided by the caller.
 //  	If you want a synchronized list, you must use the routines 
@@ -18,6 +20,50 @@
 
 #include "copyright.h"
 
+template <class T>
+void *FreeList<T>::freeObjects = NULL;
+
+//----------------------------------------------------------------------
+// FreeList<T>::Alloc
+// 	Return memory for an object of type T, off the free list.  If
+//	the free list is empty, fill it with a new slab of objects first.
+//----------------------------------------------------------------------
+
+template <class T>
+void *
+FreeList<T>::Alloc()
+{
+    void *p;
+
+    ASSERT(sizeof(T) >= sizeof(void *));	// room for the link
+    if (freeObjects == NULL) {
+	char *slab = new char[FreeListSlab * sizeof(T)];
+
+	for (int i = FreeListSlab - 1; i >= 0; i--)
+	    Free(slab + i * sizeof(T));
+    }
+    p = freeObjects;
+    freeObjects = *(void **) p;
+    return p;
+}
+
+//----------------------------------------------------------------------
+// FreeList<T>::Free
+// 	Put an object's memory on the free list, to be handed out again.
+//
+//	"p" is the memory, from Alloc.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+FreeList<T>::Free(void *p)
+{
+    if (p == NULL)
+	return;
+    *(void **) p = freeObjects;
+    freeObjects = p;
+}
+
 //----------------------------------------------------------------------
 // ListElement<T>::ListElement
 // 	Initialize a list element, so it can be added somewhere on a list.
@@ -381,3 +427,444 @@ SortedList<T>::SelfTest(T *p, int numEntries)
 
      delete q;
 }
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::IntrusiveList
+//	Initialize a list, empty to start with.
+//----------------------------------------------------------------------
+
+template <class T>
+IntrusiveList<T>::IntrusiveList()
+{ 
+    first = last = NULL; 
+    numInList = 0;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::~IntrusiveList
+//	Prepare a list for deallocation.  This does *NOT* free the 
+//	items on the list.
+//----------------------------------------------------------------------
+
+template <class T>
+IntrusiveList<T>::~IntrusiveList()
+{ 
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Append
+//      Append an "item" to the end of the list.  The item must not be
+//	on any IntrusiveList (of its type) already; its "listNext" is
+//	NULL when it is on none, so we can check (most of) that cheaply.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Append(T *item)
+{
+    ASSERT(item->listNext == NULL && item != last);
+    if (IsEmpty()) {		// list is empty
+	first = item;
+	last = item;
+    } else {			// else put it after last
+	last->listNext = item;
+	last = item;
+    }
+    numInList++;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Prepend
+//	Same as Append, only put "item" on the front.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Prepend(T *item)
+{
+    ASSERT(item->listNext == NULL && item != last);
+    if (IsEmpty()) {		// list is empty
+	first = item;
+	last = item;
+    } else {			// else put it before first
+	item->listNext = first;
+	first = item;
+    }
+    numInList++;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::RemoveFront
+//      Remove the first item from the front of the list, and return
+//	it.  List must not be empty.
+//----------------------------------------------------------------------
+
+template <class T>
+T *
+IntrusiveList<T>::RemoveFront()
+{
+    T *item = first;
+
+    ASSERT(!IsEmpty());
+    first = item->listNext;
+    if (first == NULL)		// list had one item, now has none 
+	last = NULL;
+    item->listNext = NULL;
+    numInList--;
+    return item;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Remove
+//      Remove a specific item from the list.  Must be in the list!
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Remove(T *item)
+{
+    T *prev;
+
+    if (item == first) {
+	(void) RemoveFront();
+	return;
+    }
+    for (prev = first; prev != NULL; prev = prev->listNext) {
+	if (prev->listNext == item) {
+	    prev->listNext = item->listNext;
+	    if (last == item)
+		last = prev;
+	    item->listNext = NULL;
+	    numInList--;
+	    return;
+	}
+    }
+    ASSERTNOTREACHED();		// should always find item!
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::IsInList
+//      Return TRUE if the item is in the list.
+//----------------------------------------------------------------------
+
+template <class T>
+bool
+IntrusiveList<T>::IsInList(T *item) const
+{ 
+    for (T *ptr = first; ptr != NULL; ptr = ptr->listNext) {
+        if (ptr == item)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// IntrusiveList<T>::Apply
+//      Apply function to every item on a list.
+//
+//	"func" -- the function to apply
+//----------------------------------------------------------------------
+
+template <class T>
+void
+IntrusiveList<T>::Apply(void (*func)(T *)) const
+{ 
+    for (T *ptr = first; ptr != NULL; ptr = ptr->listNext)
+        (*func)(ptr);
+}
+
+//----------------------------------------------------------------------
+// SkipList<T>::SkipList
+//	Initialize a skip list, empty to start with.
+//
+//	"comp" is the function for sorting the items (cf. SortedList)
+//----------------------------------------------------------------------
+
+template <class T>
+SkipList<T>::SkipList(int (*comp)(T x, T y))
+{ 
+    compare = comp;
+    head = new SkipNode<T>;
+    head->height = SkipMaxLevel;
+    for (int i = 0; i < SkipMaxLevel; i++)
+	head->forward[i] = NULL;
+    level = 1;
+    numInList = 0;
+    randomState = 1;
+}
+
+//----------------------------------------------------------------------
+// SkipList<T>::~SkipList
+//	Prepare a list for deallocation.  As for a List, the list should
+//	normally be empty, and the items on it are not freed; but any 
+//	elements left are.
+//----------------------------------------------------------------------
+
+template <class T>
+SkipList<T>::~SkipList()
+{ 
+    while (!IsEmpty())
+	(void) RemoveFront();
+    delete head;
+}
+
+//----------------------------------------------------------------------
+// SkipList<T>::RandomHeight
+//	Return the number of levels for a new element: 1, and one more
+//	with probability 1/4 each time, up to SkipMaxLevel.  The random
+//	numbers are from a xorshift generator.
+//----------------------------------------------------------------------
+
+template <class T>
+int
+SkipList<T>::RandomHeight()
+{
+    int height = 1;
+
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    for (unsigned int bits = randomState; (bits & 3) == 0 
+				&& height < SkipMaxLevel; bits >>= 2)
+	height++;
+    return height;
+}
+
+//----------------------------------------------------------------------
+// SkipList<T>::FindBefore
+//	Return the last element (or the head) before every element that
+//	is not less than "item".  If "update" is not NULL, set update[i]
+//	to the last such element on level i, for each level in use.
+//----------------------------------------------------------------------
+
+template <class T>
+SkipNode<T> *
+SkipList<T>::FindBefore(T item, SkipNode<T> **update) const
+{
+    SkipNode<T> *x = head;
+
+    for (int i = level - 1; i >= 0; i--) {
+	while (x->forward[i] != NULL && compare(x->forward[i]->item, item) < 0)
+	    x = x->forward[i];
+	if (update != NULL)
+	    update[i] = x;
+    }
+    return x;
+}
+
+//----------------------------------------------------------------------
+// SkipList<T>::Insert
+//      Insert an "item" into the list, after any equal to it, so that
+//	the list stays sorted in increasing order.
+//
+//	Find the last element on each level that is not greater than
+//	"item", and link the new element in after it, on as many levels
+//	as RandomHeight says.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+SkipList<T>::Insert(T item)
+{
+    SkipNode<T> *update[SkipMaxLevel];
+    SkipNode<T> *x = head, *element;
+    int height;
+
+    ASSERT(!IsInList(item));
+    for (int i = level - 1; i >= 0; i--) {
+	while (x->forward[i] != NULL && compare(x->forward[i]->item, item) <= 0)
+	    x = x->forward[i];
+	update[i] = x;
+    }
+    height = RandomHeight();
+    for (; level < height; level++)
+	update[level] = head;
+
+    element = new SkipNode<T>;
+    element->item = item;
+    element->height = height;
+    for (int i = 0; i < height; i++) {
+	element->forward[i] = update[i]->forward[i];
+	update[i]->forward[i] = element;
+    }
+    numInList++;
+}
+
+//----------------------------------------------------------------------
+// SkipList<T>::RemoveFront
+//      Remove the first "item" from the front of the list.  It is
+//	first on every level it is on, so this takes O(1) time.
+//	List must not be empty.
+// 
+// Returns:
+//	The removed item.
+//----------------------------------------------------------------------
+
+template <class T>
+T
+SkipList<T>::RemoveFront()
+{
+    SkipNode<T> *element = head->forward[0];
+    T thing;
+
+    ASSERT(!IsEmpty());
+    for (int i = 0; i < element->height; i++)
+	head->forward[i] = element->forward[i];
+    while (level > 1 && head->forward[level - 1] == NULL)
+	level--;
+    numInList--;
+    thing = element->item;
+    delete element;
+    return thing;
+}
+
+//----------------------------------------------------------------------
+// SkipList<T>::Remove
+//      Remove a specific item from the list.  Must be in the list!
+//
+//	Find the last element before those equal to "item" on each 
+//	level, then step along the equal ones to the item itself.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+SkipList<T>::Remove(T item)
+{
+    SkipNode<T> *update[SkipMaxLevel];
+    SkipNode<T> *element, *x;
+
+    element = FindBefore(item, update)->forward[0];
+    while (element != NULL && compare(element->item, item) == 0 
+					&& !(element->item == item))
+	element = element->forward[0];
+    ASSERT(element != NULL && element->item == item);
+				// should always find item!
+
+    for (int i = 0; i < element->height; i++) {
+	for (x = update[i]; x->forward[i] != element; x = x->forward[i])
+	    ASSERT(x->forward[i] != NULL);
+	x->forward[i] = element->forward[i];
+    }
+    while (level > 1 && head->forward[level - 1] == NULL)
+	level--;
+    numInList--;
+    delete element;
+}
+
+//----------------------------------------------------------------------
+// SkipList<T>::IsInList
+//      Return TRUE if the item is in the list: look among the elements
+//	equal to it.
+//----------------------------------------------------------------------
+
+template <class T>
+bool
+SkipList<T>::IsInList(T item) const
+{ 
+    SkipNode<T> *ptr = FindBefore(item, NULL)->forward[0];
+
+    for (; ptr != NULL && compare(ptr->item, item) == 0; ptr = ptr->forward[0])
+	if (item == ptr->item)
+	    return TRUE;
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// SkipList<T>::Apply
+//      Apply function to every item on the list, in order.
+//
+//	"func" -- the function to apply
+//----------------------------------------------------------------------
+
+template <class T>
+void
+SkipList<T>::Apply(void (*func)(T)) const
+{ 
+    for (SkipNode<T> *ptr = head->forward[0]; ptr != NULL; ptr = ptr->forward[0])
+        (*func)(ptr->item);
+}
+
+//----------------------------------------------------------------------
+// SkipList<T>::SanityCheck
+//      Test whether this is still a legal skip list.
+//
+//	Tests: is level 0 sorted, with the right # of elements?
+//	       is each level made of elements that are that high, in
+//	       the same order as on level 0?
+//	       are the levels above those in use empty?
+//----------------------------------------------------------------------
+
+template <class T>
+void
+SkipList<T>::SanityCheck() const
+{
+    SkipNode<T> *ptr, *below;
+    int numFound = 0;
+
+    for (ptr = head->forward[0]; ptr != NULL; ptr = ptr->forward[0]) {
+	numFound++;
+	ASSERT(numFound <= numInList);	// prevent infinite loop
+	ASSERT(ptr->height >= 1 && ptr->height <= level);
+	if (ptr->forward[0] != NULL) {
+	    ASSERT(compare(ptr->item, ptr->forward[0]->item) <= 0);
+	}
+    }
+    ASSERT(numFound == numInList);
+    for (int i = 1; i < level; i++) {
+	below = head->forward[i - 1];
+	for (ptr = head->forward[i]; ptr != NULL; ptr = ptr->forward[i]) {
+	    ASSERT(ptr->height > i);
+	    while (below != ptr) {	// must be on the level below
+		ASSERT(below != NULL);
+		below = below->forward[i - 1];
+	    }
+	}
+    }
+    for (int i = level; i < SkipMaxLevel; i++)
+	ASSERT(head->forward[i] == NULL);
+}
+
+//----------------------------------------------------------------------
+// SkipList<T>::SelfTest
+//      Test whether this module is working.
+//----------------------------------------------------------------------
+
+template <class T>
+void
+SkipList<T>::SelfTest(T *p, int numEntries)
+{
+    int i;
+    T *q = new T[numEntries];
+
+    SanityCheck();
+    ASSERT(IsEmpty());
+    for (i = 0; i < numEntries; i++) {
+	 Insert(p[i]);
+	 ASSERT(IsInList(p[i]));
+    }
+    SanityCheck();
+
+    // should be able to take out everything we put in, in any order
+    for (i = 0; i < numEntries; i++) {
+	 Remove(p[i]);
+	 ASSERT(!IsInList(p[i]));
+    }
+    ASSERT(IsEmpty());
+    SanityCheck();
+
+    for (i = 0; i < numEntries; i++)
+	 Insert(p[i]);
+    for (i = 0; i < numEntries; i++) {
+	 q[i] = RemoveFront();
+	 ASSERT(!IsInList(q[i]));
+    }
+    ASSERT(IsEmpty());
+
+    // make sure everything came out in the right order
+    for (i = 0; i < (numEntries - 1); i++) {
+	 ASSERT(compare(q[i], q[i + 1]) <= 0);
+    }
+    SanityCheck();
+
+    delete [] q;
+}
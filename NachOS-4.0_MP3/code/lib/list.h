@@ -6,6 +6,15 @@
 //	pending interrupts, etc.  Allocation and deallocation of the
 //	items on the list are to be done by the caller.
 //
+//	List elements come from a free list kept for each type of list,
+//	so once a list has been as long as it will get, putting items on
+//	it and taking them off never calls the global allocator.  An
+//	IntrusiveList, for items that can only be on one list at a time,
+//	doesn't need list elements at all.
+//
+//	A SkipList does what a SortedList does, but takes O(log n) time,
+//	rather than O(n), to insert, find or remove an item.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -16,6 +25,28 @@
 #include "copyright.h"
 #include "debug.h"
 
+#define FreeListSlab	64	// # of objects a FreeList gets at a time
+#define SkipMaxLevel	16	// most levels in a SkipList -- enough
+				// for 4^16 items
+
+// The following class hands out memory for objects of type T, out of
+// a free list.  When the free list is empty, it gets a slab of 
+// FreeListSlab objects from the global allocator; objects given back 
+// go on the free list for reuse, and slabs are never given back.
+// A class whose objects are made and deleted at a high rate can use
+// it for its "operator new" and "operator delete".
+
+template <class T>
+class FreeList {
+  public:
+    static void *Alloc();	// memory for one T
+    static void Free(void *p);	// give it back, for reuse
+
+  private:
+    static void *freeObjects;	// the free objects, each holding a 
+				// pointer to the next one
+};
+
 // The following class defines a "list element" -- which is
 // used to keep track of one item on a list.  It is equivalent to a
 // LISP cell, with a "car" ("next") pointing to the next element on the list,
@@ -30,6 +61,12 @@ class ListElement {
     ListElement(T itm); 	// initialize a list element
     ListElement *next;	     	// next element on list, NULL if this is last
     T item; 	   	     	// item on the list
+
+    void *operator new(size_t size) {	// from the free list
+	ASSERT(size == sizeof(ListElement));
+	return FreeList<ListElement>::Alloc(); 
+    }
+    void operator delete(void *p) { FreeList<ListElement>::Free(p); }
 };
 
 // The following class defines a "list" -- a singly linked list of
@@ -136,6 +173,140 @@ class ListIterator {
     ListElement<T> *current;	// where we are in the list
 };
 
+// The following class defines an "intrusive list" -- a singly linked
+// list of items that carry their own link, a "listNext" field:
+//
+//	class Thing {
+//	    ...
+//	    Thing *listNext;	// next Thing on the list it is on;
+//	};			// NULL when on none (set it so at first)
+//
+// so putting an item on the list never allocates anything.  The 
+// catch is that an item can be on only one such list at a time (but
+// it can be on any number of Lists).  The list holds pointers to 
+// the items; as with List, the items belong to the caller.
+
+template <class T>
+class IntrusiveList {
+  public:
+    IntrusiveList();		// initialize the list
+    ~IntrusiveList();		// de-allocate the list
+
+    void Prepend(T *item);	// Put item at the beginning of the list
+    void Append(T *item); 	// Put item at the end of the list
+
+    T *Front() { return first; }
+    				// Return first item on list
+				// without removing it
+    T *RemoveFront(); 		// Take item off the front of the list
+    void Remove(T *item); 	// Remove specific item from list
+
+    bool IsInList(T *item) const;// is the item in the list?
+
+    unsigned int NumInList() { return numInList;};
+    				// how many items in the list?
+    bool IsEmpty() { return (numInList == 0); };
+    				// is the list empty? 
+
+    void Apply(void (*f)(T *)) const; 
+    				// apply function to all items in list
+
+  private:
+    T *first;  			// Head of the list, NULL if list is empty
+    T *last;			// Last item on the list
+    int numInList;		// number of items in list
+};
+
+// The following class defines a "skip list" -- a sorted list, with the
+// same operations as SortedList, in which each element is also on a 
+// random number of higher levels: level 0 is the whole list, and each
+// level above it has about a quarter of the elements of the one below.
+// A search starts on the top level, and drops a level whenever the next
+// element on its level is too far; so it skips most of the list, and 
+// finds its place after O(log n) steps on average.
+//
+// As in a SortedList, items that compare equal come out in the order 
+// they went in.  Random levels come from the list's own generator, so
+// a run of Nachos is repeatable, whatever else uses random numbers.
+
+template <class T> class SkipListIterator;
+
+template <class T>
+class SkipNode {
+  public:
+    T item;			// item on the list
+    int height;			// # of levels it is on
+    SkipNode *forward[SkipMaxLevel];	// next element on each level
+
+    void *operator new(size_t size) { return FreeList<SkipNode>::Alloc(); }
+    void operator delete(void *p) { FreeList<SkipNode>::Free(p); }
+};
+
+template <class T>
+class SkipList {
+  public:
+    SkipList(int (*comp)(T x, T y));	// initialize the list
+    ~SkipList();		// de-allocate the list
+
+    void Insert(T item); 	// insert an item onto the list in sorted order
+
+    T Front() { return head->forward[0]->item; }
+    				// Return first item on list
+				// without removing it
+    T RemoveFront(); 		// Take item off the front of the list
+    void Remove(T item); 	// Remove specific item from list
+
+    bool IsInList(T item) const;// is the item in the list?
+
+    unsigned int NumInList() { return numInList;};
+    				// how many items in the list?
+    bool IsEmpty() { return (numInList == 0); };
+    				// is the list empty? 
+
+    void Apply(void (*f)(T)) const; 
+    				// apply function to all elements in list
+
+    void SanityCheck() const;	// has this list been corrupted?
+    void SelfTest(T *p, int numEntries);
+				// verify module is working
+
+  private:
+    int (*compare)(T x, T y);	// function for sorting list elements
+    SkipNode<T> *head;		// not an element: forward[i] is the first
+				// element on level i, NULL if none
+    int level;			// # of levels in use
+    int numInList;		// number of elements in list
+    unsigned int randomState;	// for choosing levels
+
+    int RandomHeight();		// # of levels for a new element
+    SkipNode<T> *FindBefore(T item, SkipNode<T> **update) const;
+				// last element before any equal to "item"
+
+    friend class SkipListIterator<T>;
+};
+
+// The following class can be used to step through a skip list, as
+// ListIterator does a list.
+
+template <class T>
+class SkipListIterator {
+  public:
+    SkipListIterator(SkipList<T> *list) { current = list->head->forward[0]; }
+				// initialize an iterator
+
+    bool IsDone() { return current == NULL; };
+				// return TRUE if we are at the end of the list
+
+    T Item() { ASSERT(!IsDone()); return current->item; };
+				// return current element on list
+
+    void Next() { current = current->forward[0]; };		
+				// update iterator to point to next
+
+  private:
+    SkipNode<T> *current;	// where we are in the list
+};
+
 #include "list.cc"		// templates are really like macros
 				// so needs to be included in every
 				// file that uses the template
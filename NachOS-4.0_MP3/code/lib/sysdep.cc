@@ -32,7 +32,9 @@
 #include <sys/file.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <poll.h>
 #include <cerrno>
+#include <pthread.h>
 
 #ifdef SOLARIS
 // KMS
@@ -45,6 +47,17 @@
 #endif
 #ifdef DOS	// neither does DOS
 #define NO_MPROT
+#define NO_MMAP
+#endif
+
+#ifndef NO_MMAP			// for thread stacks, cf. AllocStack
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
 #endif
 
 extern "C" {
@@ -149,6 +162,21 @@ UDelay(unsigned int useconds)
 
 }
 
+//----------------------------------------------------------------------
+// HostTime
+// 	Return the time of day on the host, in seconds, to time parts of
+//	Nachos itself (not the simulation: that is what stats are for).
+//----------------------------------------------------------------------
+
+double
+HostTime()
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1000000.0;
+}
+
 //----------------------------------------------------------------------
 // Abort
 // 	Quit and drop core.
@@ -203,6 +231,10 @@ RandomNumber()
 //
 //	Note: Just return the useful part!
 //
+//	mprotect only works on whole pages, so the array is put at the
+//	first page boundary in what we allocate, and the boundary pages
+//	are whole pages; the address to delete is kept in the first one.
+//
 //	"size" -- amount of useful space needed (in bytes)
 //----------------------------------------------------------------------
 
@@ -213,11 +245,18 @@ AllocBoundedArray(int size)
     return new char[size];
 #else
     int pgSize = getpagesize();
-    char *ptr = new char[pgSize * 2 + size];
+    char *ptr, *base;
+    int retVal;
 
-    mprotect(ptr, pgSize, 0);
-    mprotect(ptr + pgSize + size, pgSize, 0);
-    return ptr + pgSize;
+    size = divRoundUp(size, pgSize) * pgSize;
+    ptr = new char[pgSize * 3 + size];
+    base = (char *) (divRoundUp((unsigned long) ptr, pgSize) * pgSize);
+    *(char **) base = ptr;
+    retVal = mprotect(base, pgSize, 0);
+    ASSERT(retVal == 0);
+    retVal = mprotect(base + pgSize + size, pgSize, 0);
+    ASSERT(retVal == 0);
+    return base + pgSize;
 #endif
 }
 
@@ -240,60 +279,124 @@ void
 DeallocBoundedArray(char *ptr, int size)
 {
     int pgSize = getpagesize();
+    int retVal;
 
-    mprotect(ptr - pgSize, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    delete [] (ptr - pgSize);
+    size = divRoundUp(size, pgSize) * pgSize;
+    retVal = mprotect(ptr - pgSize, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
+    ASSERT(retVal == 0);
+    retVal = mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
+    ASSERT(retVal == 0);
+    delete [] *(char **) (ptr - pgSize);
 }
 #endif
 
 //----------------------------------------------------------------------
-// PollFile
-// 	Check open file or open socket to see if there are any 
-//	characters that can be read immediately.  If so, read them
-//	in, and return TRUE.
+// AllocStack
+// 	Return a thread stack, with an inaccessible page just before and
+//	after it, so that a thread overflowing its stack traps right
+//	away, rather than being caught (maybe) at its next context
+//	switch by Thread::CheckOverflow.
 //
-//	"fd" -- the file descriptor of the file to be polled
+//	The stack is reserved with mmap, so the host only commits its
+//	pages (zero-filled) as the thread first touches them; most
+//	threads use a small part of their stack.  A stack freed by 
+//	DeallocStack is reused as it is, without being zeroed.
+//
+//	"size" -- amount of useful space needed (in bytes); rounded up 
+//		to a whole number of pages
 //----------------------------------------------------------------------
 
-bool
-PollFile(int fd)
+#define StackPoolSize	32		// most freed stacks kept for reuse
+
+static char *freeStacks = NULL;		// freed stacks, linked through 
+					// their first word
+static int numFreeStacks = 0;		// # of stacks in freeStacks
+static int freeStackSize = 0;		// their size (in bytes)
+
+char * 
+AllocStack(int size)
 {
-#if defined(SOLARIS) || defined(LINUX)
-// KMS
-    fd_set rfd,wfd,xfd;
+#ifdef NO_MMAP
+    return AllocBoundedArray(size);
 #else
-    int rfd = (1 << fd), wfd = 0, xfd = 0;
-#endif
+    int pgSize = getpagesize();
+    char *ptr;
     int retVal;
-    struct timeval pollTime;
 
-#if defined(SOLARIS) || defined(LINUX)
-// KMS
-    FD_ZERO(&rfd);
-    FD_ZERO(&wfd);
-    FD_ZERO(&xfd);
-    FD_SET(fd,&rfd);
+    size = divRoundUp(size, pgSize) * pgSize;
+    if (freeStacks != NULL && size == freeStackSize) {
+	ptr = freeStacks;
+	freeStacks = *(char **) ptr;
+	numFreeStacks--;
+	return ptr;
+    }
+    ptr = (char *) mmap(NULL, pgSize * 2 + size, PROT_NONE, 
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    ASSERT(ptr != (char *) MAP_FAILED);
+    retVal = mprotect(ptr + pgSize, size, PROT_READ | PROT_WRITE);
+    ASSERT(retVal == 0);
+    return ptr + pgSize;
 #endif
+}
 
-// don't wait if there are no characters on the file
-    pollTime.tv_sec = 0;
-    pollTime.tv_usec = 0;
+//----------------------------------------------------------------------
+// DeallocStack
+// 	Give back a stack from AllocStack.  Keep it for reuse if there
+//	is room in the pool; otherwise unmap it, and its guard pages.
+//
+//	"ptr" -- the stack
+//	"size" -- amount of useful space in the stack (in bytes)
+//----------------------------------------------------------------------
 
-// poll file or socket
-#if defined(BSD)
-    retVal = select(32, (fd_set*)&rfd, (fd_set*)&wfd, (fd_set*)&xfd, &pollTime);
-#elif defined(SOLARIS) || defined(LINUX)
-    // KMS
-    retVal = select(32, &rfd, &wfd, &xfd, &pollTime);
+void 
+DeallocStack(char *ptr, int size)
+{
+#ifdef NO_MMAP
+    DeallocBoundedArray(ptr, size);
 #else
-    retVal = select(32, &rfd, &wfd, &xfd, &pollTime);
+    int pgSize = getpagesize();
+
+    size = divRoundUp(size, pgSize) * pgSize;
+    if (numFreeStacks < StackPoolSize 
+		&& (freeStacks == NULL || size == freeStackSize)) {
+	*(char **) ptr = freeStacks;
+	freeStacks = ptr;
+	freeStackSize = size;
+	numFreeStacks++;
+	return;
+    }
+    munmap(ptr - pgSize, pgSize * 2 + size);
 #endif
+}
+
+//----------------------------------------------------------------------
+// PollFile
+// 	Check open file or open socket to see if there are any 
+//	characters that can be read immediately.  If so, return TRUE.
+//	If not, wait for some to arrive, for up to "msecs" milliseconds
+//	(0 means don't wait).
+//
+//	"fd" -- the file descriptor of the file to be polled
+//	"msecs" -- how long to wait
+//----------------------------------------------------------------------
+
+bool
+PollFile(int fd, int msecs)
+{
+    struct pollfd pfd;
+    int retVal;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    do {
+	retVal = poll(&pfd, 1, msecs);
+    } while (retVal < 0 && errno == EINTR);
 
     ASSERT((retVal == 0) || (retVal == 1));
     if (retVal == 0)
 	return FALSE;                 		// no char waiting to be read
-    return TRUE;
+    return TRUE;				// a char, or the end of the file
 }
 
 //----------------------------------------------------------------------
@@ -569,3 +672,103 @@ SendToSocket(int sockID, char *buffer, int packetSize, char *toName)
     // This may mask other kinds of failures, but it is the
     // right thing to do in the common case.
 }
+
+//----------------------------------------------------------------------
+// Host threads
+// 	A pool of host threads, started once, that run batches of jobs 
+//	in parallel.  The thread handing out a batch works on it too, 
+//	and returns once every job in the batch is done.
+//
+//	Everything below is protected by hostLock.
+//----------------------------------------------------------------------
+
+static pthread_mutex_t hostLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t hostWork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t hostDone = PTHREAD_COND_INITIALIZER;
+static void (*hostFunc)(void *);	// the batch being run
+static void **hostArgs;
+static int hostNext = 0;		// next job to hand out
+static int hostCount = 0;		// # of jobs in the batch
+static int hostPending = 0;		// # of jobs not yet finished
+
+//----------------------------------------------------------------------
+// RunHostJob
+// 	Take the next job of the batch, if any, and run it with hostLock
+//	released.  Return FALSE if there was nothing left to take.
+//----------------------------------------------------------------------
+
+static bool
+RunHostJob()
+{
+    int job;
+
+    if (hostNext >= hostCount)
+	return FALSE;
+    job = hostNext++;
+    pthread_mutex_unlock(&hostLock);
+    (*hostFunc)(hostArgs[job]);
+    pthread_mutex_lock(&hostLock);
+    if (--hostPending == 0)
+	pthread_cond_signal(&hostDone);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// HostThreadBody
+// 	Body of each host thread in the pool: wait for jobs, forever.
+//----------------------------------------------------------------------
+
+static void *
+HostThreadBody(void *)
+{
+    pthread_mutex_lock(&hostLock);
+    for (;;) {
+	while (hostNext >= hostCount)
+	    pthread_cond_wait(&hostWork, &hostLock);
+	RunHostJob();
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// StartHostThreads
+// 	Add "n" host threads to the pool.  They are never stopped; they
+//	go away when Nachos exits.
+//----------------------------------------------------------------------
+
+void
+StartHostThreads(int n)
+{
+    pthread_t tid;
+    int err;
+
+    for (int i = 0; i < n; i++) {
+	err = pthread_create(&tid, NULL, HostThreadBody, NULL);
+	ASSERT(err == 0);
+	pthread_detach(tid);
+    }
+}
+
+//----------------------------------------------------------------------
+// RunOnHostThreads
+// 	Call "func" on each of "args[0..count-1]", spread over the host
+//	threads, and wait until all the calls have returned.
+//----------------------------------------------------------------------
+
+void
+RunOnHostThreads(void (*func)(void *), void **args, int count)
+{
+    pthread_mutex_lock(&hostLock);
+    hostFunc = func;
+    hostArgs = args;
+    hostNext = 0;
+    hostPending = count;
+    hostCount = count;
+    pthread_cond_broadcast(&hostWork);
+    while (RunHostJob())		// lend a hand
+	;
+    while (hostPending > 0)
+	pthread_cond_wait(&hostDone, &hostLock);
+    hostNext = hostCount = 0;
+    pthread_mutex_unlock(&hostLock);
+}
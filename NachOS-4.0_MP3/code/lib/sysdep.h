@@ -24,6 +24,7 @@ extern void Abort();
 extern void Exit(int exitCode);
 extern void Delay(int seconds);
 extern void UDelay(unsigned int usec);// rcgood - to avoid spinners.
+extern double HostTime();	// host clock, in seconds
 
 // Initialize system so that cleanUp routine is called when user hits ctl-C
 extern void CallOnUserAbort(void (*cleanup)(int));
@@ -37,9 +38,15 @@ extern unsigned int RandomNumber();
 extern char *AllocBoundedArray(int size);
 extern void DeallocBoundedArray(char *p, int size);
 
+// Allocate, de-allocate a thread stack, bounded the same way; 
+// de-allocated stacks are kept for reuse
+extern char *AllocStack(int size);
+extern void DeallocStack(char *p, int size);
+
 // Check file to see if there are any characters to be read.
-// If no characters in the file, return without waiting.
-extern bool PollFile(int fd);
+// If no characters in the file, wait up to "msecs" milliseconds
+// for some (by default, return without waiting).
+extern bool PollFile(int fd, int msecs = 0);
 
 // File operations: open/read/write/lseek/close, and check for error
 // For simulating the disk and the console devices.
@@ -63,6 +70,10 @@ void bcopy(const void *s1, void *s2, size_t n);
 void bzero(void *s, size_t n);
 }
 
+// Host threads, for simulating several CPUs at once (cf. cpu.h)
+extern void StartHostThreads(int n);
+extern void RunOnHostThreads(void (*func)(void *), void **args, int count);
+
 // Interprocess communication operations, for simulating the network
 extern int OpenSocket();
 extern void CloseSocket(int sockID);
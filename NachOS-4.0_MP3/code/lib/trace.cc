@@ -0,0 +1,106 @@
+// trace.cc
+//	Routines to record scheduling events in a trace file, and to
+//	print them as text.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "trace.h"
+
+static const char *queueNames[] = { "SJF", "RR", "Priority" };
+
+//----------------------------------------------------------------------
+// TraceBuffer::TraceBuffer
+// 	Create (or truncate) the trace file, and write its magic number.
+//
+//	"fileName" -- UNIX file to write the trace to
+//----------------------------------------------------------------------
+
+TraceBuffer::TraceBuffer(char *fileName)
+{
+    int magic = TraceMagic;
+
+    fileno = OpenForWrite(fileName);
+    WriteFile(fileno, (char *) &magic, sizeof(int));
+    events = new TraceEvent[TraceBufferSize];
+    numEvents = 0;
+}
+
+//----------------------------------------------------------------------
+// TraceBuffer::~TraceBuffer
+// 	Write out the events still in the buffer, and close the file.
+//----------------------------------------------------------------------
+
+TraceBuffer::~TraceBuffer()
+{
+    Flush();
+    Close(fileno);
+    delete [] events;
+}
+
+//----------------------------------------------------------------------
+// TraceBuffer::Flush
+// 	Write the buffered events to the file, in one go, and empty the
+//	buffer.
+//----------------------------------------------------------------------
+
+void
+TraceBuffer::Flush()
+{
+    if (numEvents > 0)
+	WriteFile(fileno, (char *) events, numEvents * sizeof(TraceEvent));
+    numEvents = 0;
+}
+
+//----------------------------------------------------------------------
+// PrintTraceEvent
+// 	Print "event" to stdout, as a line of the text trace.  Device
+//	events print nothing.
+//----------------------------------------------------------------------
+
+void
+PrintTraceEvent(TraceEvent *event)
+{
+    switch (event->kind) {
+      case TraceNew:
+	cout << "Thread " << event->thread << "\tProcessNew\t" << event->tick << endl;
+	break;
+      case TraceReady:
+	cout << "Thread " << event->thread << "\tProcessReady\t" << event->tick << endl;
+	break;
+      case TraceRunning:
+	cout << "Thread " << event->thread << "\tProcessRunning\t" << event->tick << endl;
+	break;
+      case TraceSleep:
+	cout << "Thread " << event->thread << "\tProcessSleep\t" << event->tick << endl;
+	break;
+      case TraceFinish:
+	cout << "Thread " << event->thread << "\tProcessFinish\t" << event->tick << endl;
+	break;
+      case TraceQueue:
+	ASSERT(event->queue <= TracePriorityQueue);
+	cout << "Tick " << event->tick << " Thread " << event->thread
+	     << " move to " << queueNames[event->queue] << " queue" << endl;
+	break;
+      case TracePriority:
+	cout << "Tick " << event->tick << " Thread" << event->thread
+	     << " changes its priority to " << (int) event->value << endl;
+	break;
+      case TraceBurst:
+	cout << "Tick " << event->tick << " Thread " << event->thread
+	     << " change its burst time to " << event->value << endl;
+	break;
+      case TraceInterrupt:
+      case TraceDiskStart:
+      case TraceDiskDone:
+      case TraceConsoleWrite:
+      case TraceConsoleDone:
+      case TraceConsoleRead:
+	break;				// not part of the text trace
+      default:
+	ASSERTNOTREACHED();
+    }
+}
@@ -0,0 +1,86 @@
+// trace.h
+//	Data structures for a binary trace of scheduling events.
+//
+//	Without the -trace flag, Nachos prints a line of text for every
+//	change in a thread's state ("Thread 3  ProcessReady  120"), and
+//	flushes stdout each time.  With -trace, each event is instead
+//	stored as a small fixed-size record in a buffer, and the buffer
+//	is written to a file in large blocks: when it fills up, and when
+//	Nachos halts.  The "tracecat" tool (cf. tools/tracecat.cc) turns
+//	the file back into the text Nachos would have printed.
+//
+//	Both print through PrintTraceEvent, so the two always agree.
+//
+//	The trace file also records device activity (interrupts, disk
+//	requests, console characters), which has no text form;
+//	"tracecat -chrome" shows it, along with the threads' states,
+//	in the Chrome trace viewer or Perfetto.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "copyright.h"
+
+#define TraceMagic	0x4e545243	// "NTRC" -- first word of a trace
+#define TraceBufferSize	4096		// events buffered between writes
+
+// What happened
+enum TraceKind { TraceNew, TraceReady, TraceRunning, TraceSleep,
+		 TraceFinish, TraceQueue, TracePriority, TraceBurst,
+		 // device events, in the trace file only
+		 TraceInterrupt, TraceDiskStart, TraceDiskDone,
+		 TraceConsoleWrite, TraceConsoleDone, TraceConsoleRead };
+
+// Which ready queue a thread moved to (TraceQueue)
+enum TraceQueueId { TraceSJFQueue, TraceRRQueue, TracePriorityQueue };
+
+// The following class defines one event, as stored in the trace file
+// (in host byte order).
+
+class TraceEvent {
+  public:
+    int tick;			// when it happened
+    int thread;			// thread ID (for device events, the
+				// thread running at the time, or -1)
+    double value;		// new priority (TracePriority),
+				// burst time (TraceBurst), sector
+				// (TraceDiskStart) or # of characters
+				// (TraceConsoleWrite, TraceConsoleRead)
+    unsigned char kind;		// a TraceKind
+    unsigned char from;		// thread state before and after
+    unsigned char to;		// (a ThreadStatus)
+    unsigned char queue;	// a TraceQueueId (TraceQueue), an
+				// IntType (TraceInterrupt), or
+				// TRUE for a disk write (TraceDiskStart)
+};
+
+// The following class defines a buffer of events, on their way to a
+// trace file.
+
+class TraceBuffer {
+  public:
+    TraceBuffer(char *fileName);	// Start a new trace file
+    ~TraceBuffer();			// Write out what is left, and
+					// close the file
+
+    void Record(TraceEvent *event) {	// Add an event to the trace
+	events[numEvents++] = *event;
+	if (numEvents == TraceBufferSize)
+	    Flush();
+    }
+    void Flush();			// Write out the buffered events
+
+  private:
+    int fileno;				// UNIX file descriptor
+    TraceEvent *events;			// the buffer
+    int numEvents;			// # of events in the buffer
+};
+
+extern void PrintTraceEvent(TraceEvent *event);
+					// Print an event as text
+
+#endif // TRACE_H
@@ -21,7 +21,7 @@
 // 	Initialize the simulation of the input for a hardware console device.
 //
 //	"readFile" -- UNIX file simulating the keyboard (NULL -> use stdin)
-// 	"toCall" is the interrupt handler to call when a character arrives
+// 	"toCall" is the interrupt handler to call when characters arrive
 //		from the keyboard
 //----------------------------------------------------------------------
 
@@ -34,10 +34,15 @@ ConsoleInput::ConsoleInput(char *readFile, CallBackObj *toCall)
 
     // set up the stuff to emulate asynchronous interrupts
     callWhenAvail = toCall;
-    incoming = EOF;
+    numIncoming = nextIncoming = 0;
+    polling = FALSE;
+    atEOF = FALSE;
+    pollDelay = ConsoleTime;
+    hostWait = 1;
 
-    // start polling for incoming keystrokes
-    //kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
+    // we don't poll for keystrokes until someone asks for them (Poll);
+    // otherwise, there would always be a pending interrupt, and the
+    // machine would never run out of things to do
 }
 
 //----------------------------------------------------------------------
@@ -51,67 +56,85 @@ ConsoleInput::~ConsoleInput()
 	Close(readFileNo);
 }
 
+//----------------------------------------------------------------------
+// ConsoleInput::Poll()
+// 	Schedule a poll of the simulated keyboard, unless one is already
+//	scheduled, there are characters not yet taken, or the input has
+//	ended.
+//----------------------------------------------------------------------
+
+void
+ConsoleInput::Poll()
+{
+    if (polling || nextIncoming < numIncoming || atEOF)
+	return;
+    polling = TRUE;
+    kernel->interrupt->Schedule(this, pollDelay, ConsoleReadInt);
+}
 
 //----------------------------------------------------------------------
 // ConsoleInput::CallBack()
-// 	Simulator calls this when a character may be available to be
+// 	Simulator calls this when characters may be available to be
 //	read in from the simulated keyboard (eg, the user typed something).
 //
-//	First check to make sure character is available.
-//	Then invoke the "callBack" registered by whoever wants the character.
+//	If nothing has been typed, poll again later, backing off up to
+//	MaxPollDelay.  Otherwise read in what has been typed, and invoke
+//	the "callBack" registered by whoever wants it.  The next poll
+//	waits until those characters would have crossed the line.
 //----------------------------------------------------------------------
 
 void
 ConsoleInput::CallBack()
 {
-  char c;
-  int readCount;
-
-    ASSERT(incoming == EOF);
-    if (!PollFile(readFileNo)) { // nothing to be read
-        // schedule the next time to poll for a packet
-        kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
-    } else { 
-    	// otherwise, try to read a character
-    	readCount = ReadPartial(readFileNo, &c, sizeof(char));
-	if (readCount == 0) {
-	   // this seems to happen at end of file, when the
-	   // console input is a regular file
-	   // don't schedule an interrupt, since there will never
-	   // be any more input
-	   // just do nothing....
-	}
-	else {
-	  // save the character and notify the OS that
-	  // it is available
-	  ASSERT(readCount == sizeof(char));
-	  incoming = c;
-	  kernel->stats->numConsoleCharsRead++;
-	}
-	callWhenAvail->CallBack();
+    int wait = 0;
+    int readCount;
+
+    ASSERT(polling && nextIncoming == numIncoming);
+    polling = FALSE;
+    if (kernel->interrupt->getStatus() == IdleMode)
+	wait = hostWait;	// nothing else to simulate
+    if (!PollFile(readFileNo, wait)) { // nothing to be read
+	pollDelay = min(pollDelay * 2, MaxPollDelay);
+	if (wait > 0)
+	    hostWait = min(hostWait * 2, MaxHostWait);
+        // schedule the next time to poll for a keystroke
+	Poll();
+	return;
     }
+    readCount = ReadPartial(readFileNo, incoming, ConsoleReadSize);
+    if (readCount <= 0) {
+	// this happens at end of file, when the console input is a
+	// regular file (or ^D at a terminal); don't schedule another
+	// poll, since there will never be any more input
+	atEOF = TRUE;
+    } else {
+	// save the characters and notify the OS that they are available
+	numIncoming = readCount;
+	nextIncoming = 0;
+	kernel->stats->numConsoleCharsRead += readCount;
+	kernel->TraceDevice(TraceConsoleRead, 0, readCount);
+	pollDelay = ConsoleTime * readCount;
+	hostWait = 1;
+    }
+    callWhenAvail->CallBack();
 }
 
 //----------------------------------------------------------------------
-// ConsoleInput::GetChar()
-// 	Read a character from the input buffer, if there is any there.
-//	Either return the character, or EOF if none buffered.
+// ConsoleInput::GetChars()
+// 	Take up to "n" characters from the input buffer, into "data".
+//	Return how many there were (0 if none are buffered).
 //----------------------------------------------------------------------
 
-char
-ConsoleInput::GetChar()
+int
+ConsoleInput::GetChars(char *data, int n)
 {
-   char ch = incoming;
-
-   if (incoming != EOF) {	// schedule when next char will arrive
-       kernel->interrupt->Schedule(this, ConsoleTime, ConsoleReadInt);
-   }
-   incoming = EOF;
-   return ch;
+    if (n > numIncoming - nextIncoming)
+	n = numIncoming - nextIncoming;
+    bcopy(incoming + nextIncoming, data, n);
+    nextIncoming += n;
+    return n;
 }
 
-
-
 //----------------------------------------------------------------------
 // ConsoleOutput::ConsoleOutput
 // 	Initialize the simulation of the output for a hardware console device.
@@ -119,10 +142,14 @@ ConsoleInput::GetChar()
 //	"writeFile" -- UNIX file simulating the display (NULL -> use stdout)
 // 	"toCall" is the interrupt handler to call when a write to 
 //	the display completes.
+//	"bufferSize" -- # of characters the device can hold before they
+//	go out to the display
 //----------------------------------------------------------------------
 
-ConsoleOutput::ConsoleOutput(char *writeFile, CallBackObj *toCall)
+ConsoleOutput::ConsoleOutput(char *writeFile, CallBackObj *toCall, 
+							int bufferSize)
 {
+    ASSERT(bufferSize >= 1);
     if (writeFile == NULL)
 	writeFileNo = 1;				// display = stdout
     else
@@ -130,55 +157,124 @@ ConsoleOutput::ConsoleOutput(char *writeFile, CallBackObj *toCall)
 
     callWhenDone = toCall;
     putBusy = FALSE;
+    this->bufferSize = bufferSize;
+    buffer = new char[bufferSize];
+    numBuffered = 0;
+    burstSize = 0;
 }
 
 //----------------------------------------------------------------------
 // ConsoleOutput::~ConsoleOutput
-// 	Clean up console output emulation
+// 	Clean up console output emulation.  Characters still waiting in
+//	the buffer are written out, so that nothing put before Halt
+//	is lost.
 //----------------------------------------------------------------------
 
 ConsoleOutput::~ConsoleOutput()
 {
+    if (numBuffered > burstSize)
+	WriteFile(writeFileNo, buffer + burstSize, numBuffered - burstSize);
+    delete [] buffer;
     if (writeFileNo != 1)
 	Close(writeFileNo);
 }
 
+//----------------------------------------------------------------------
+// ConsoleOutput::StartBurst()
+// 	Send everything in the buffer to the simulated display, with one
+//	write, and schedule an interrupt for when the last character of
+//	it has crossed the line.
+//----------------------------------------------------------------------
+
+void
+ConsoleOutput::StartBurst()
+{
+    ASSERT(putBusy == FALSE && numBuffered > 0);
+    WriteFile(writeFileNo, buffer, numBuffered);
+    burstSize = numBuffered;
+    putBusy = TRUE;
+    kernel->TraceDevice(TraceConsoleWrite, 0, burstSize);
+    kernel->interrupt->Schedule(this, ConsoleTime * burstSize, 
+							ConsoleWriteInt);
+}
+
 //----------------------------------------------------------------------
 // ConsoleOutput::CallBack()
-// 	Simulator calls this when the next character can be output to the
-//	display.
+// 	Simulator calls this when a burst has gone out to the display.
+//	Free its room in the buffer, and start sending whatever was put
+//	in the meantime.
 //----------------------------------------------------------------------
 
 void
 ConsoleOutput::CallBack()
 {
     putBusy = FALSE;
-    kernel->stats->numConsoleCharsWritten++;
+    if (burstSize == 0) 	// a PutInt
+	kernel->stats->numConsoleCharsWritten++;
+    else {
+	kernel->stats->numConsoleCharsWritten += burstSize;
+	numBuffered -= burstSize;
+	memmove(buffer, buffer + burstSize, numBuffered);
+	burstSize = 0;
+    }
+    kernel->TraceDevice(TraceConsoleDone);
+    if (numBuffered > 0)
+	StartBurst();
     callWhenDone->CallBack();
 }
 
+//----------------------------------------------------------------------
+// ConsoleOutput::PutChars()
+// 	Put as many of "data[0..n-1]" in the buffer as there is room for,
+//	and return how many.  If the line is free, they go out to the 
+//	display at once; otherwise, with the next burst.
+//----------------------------------------------------------------------
+
+int
+ConsoleOutput::PutChars(char *data, int n)
+{
+    int room = bufferSize - numBuffered;
+
+    if (n > room)
+	n = room;
+    bcopy(data, buffer + numBuffered, n);
+    numBuffered += n;
+    if (!putBusy && numBuffered > 0)
+	StartBurst();
+    return n;
+}
+
 //----------------------------------------------------------------------
 // ConsoleOutput::PutChar()
 // 	Write a character to the simulated display, schedule an interrupt 
-//	to occur in the future, and return.
+//	to occur in the future, and return.  (If the line is busy, the 
+//	character waits in the buffer.)
 //----------------------------------------------------------------------
 
 void
 ConsoleOutput::PutChar(char ch)
 {
-    ASSERT(putBusy == FALSE);
-    WriteFile(writeFileNo, &ch, sizeof(char));
-    putBusy = TRUE;
-    kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
+    int n = PutChars(&ch, 1);
+
+    ASSERT(n == 1);
 }
+
+//----------------------------------------------------------------------
+// ConsoleOutput::PutInt()
+// 	Write a number, and a newline, to the simulated display, all in 
+//	one character time.
+//----------------------------------------------------------------------
+
 void
 ConsoleOutput::PutInt(int number)
 {
     ASSERT(putBusy == FALSE);
-    char temp[10];
+    char temp[13];
     sprintf(temp,"%d\n",number);
     WriteFile(writeFileNo, (char*)&temp, sizeof(char)*strlen(temp));
     putBusy = TRUE;
+    burstSize = 0;
+    kernel->TraceDevice(TraceConsoleWrite, 0, 1);
     kernel->interrupt->Schedule(this, ConsoleTime, ConsoleWriteInt);
    
 }
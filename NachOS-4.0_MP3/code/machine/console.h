@@ -13,6 +13,21 @@
 //	to the console has limited bandwidth (like a modem!), and so
 //	each character takes measurable time.
 //
+//	The keyboard side is only watched while someone wants input.
+//	It is polled, less and less often while nothing is typed (so an
+//	idle keyboard costs few interrupts), and each poll takes in all
+//	the characters typed so far, up to ConsoleReadSize, at once.  If
+//	the machine has nothing else to do, the poll waits a little for
+//	the host file, rather than spinning.
+//
+//	The display side has a buffer (a FIFO) of some number of
+//	characters.  Characters put while the line is busy wait in the
+//	buffer; when the line is free, everything in the buffer goes out 
+//	as one burst -- one write to the UNIX file, and one interrupt once
+//	the whole burst has crossed the line, which takes ConsoleTime per
+//	character, just as if they had been sent one at a time.  A buffer 
+//	of one character is the original device.
+//
 //	The user of the device registers itself to be called "back" when 
 //	the read/write interrupts occur.  There is a separate interrupt
 //	for read and write, and the device is "duplex" -- a character
@@ -31,14 +46,21 @@
 #include "utility.h"
 #include "callback.h"
 
+#define ConsoleReadSize	128	// most characters taken in by one poll
+#define MaxPollDelay	(64 * ConsoleTime)
+				// longest wait between polls of an idle
+				// keyboard
+#define MaxHostWait	64	// longest wait, in host milliseconds, in
+				// one poll while the machine is idle
+
 // The following two classes define the input (and output) side of a 
 // hardware console device.  Input (and output) to the device is simulated 
 // by reading (and writing) to the UNIX file "readFile" (and "writeFile").
 //
 // Since input (and output) to the device is asynchronous, the interrupt 
 // handler "callWhenAvail" is called when a character has arrived to be 
-// read in (and "callWhenDone" is called when an output character has been 
-// "put" so that the next character can be written).
+// read in (and "callWhenDone" is called when a burst of output has been 
+// "put", freeing its room in the buffer).
 //
 // In practice, usually a single hardware thing that does both
 // serial input and serial output.  But conceptually simpler to
@@ -50,41 +72,65 @@ class ConsoleInput : public CallBackObj {
 				// initialize hardware console input 
     ~ConsoleInput();		// clean up console emulation
 
-    char GetChar();	   	// Poll the console input.  If a char is 
-				// available, return it.  Otherwise, return EOF.
-    				// "callWhenAvail" is called whenever there is 
-				// a char to be gotten
+    void Poll();		// Start watching the keyboard, if we
+				// aren't already.  "callWhenAvail" is
+				// called when some chars have been typed,
+				// or the input has ended.
+    int GetChars(char *data, int n);
+				// Take up to "n" of the chars that have
+				// been typed, and return how many
+    bool AtEOF() { return atEOF; }
+				// Has the input ended?
 
-    void CallBack();		// Invoked when a character arrives
-				// from the keyboard.
+    void CallBack();		// Invoked when it's time to poll the
+				// keyboard.
 
   private:
     int readFileNo;			// UNIX file emulating the keyboard 
     CallBackObj *callWhenAvail;		// Interrupt handler to call when 
-					// there is a char to be read
-    char incoming;    			// Contains the character to be read,
-					// if there is one available. 
-					// Otherwise contains EOF.
+					// there are chars to be read
+    char incoming[ConsoleReadSize];	// Contains the characters typed,
+    int numIncoming;			// this many of them,
+    int nextIncoming;			// from this one on, not yet taken
+    bool polling;			// Is a poll scheduled?
+    bool atEOF;				// Has the input ended?
+    int pollDelay;			// Ticks until the next poll
+    int hostWait;			// Host msecs an idle machine waits
+					// in the next poll
 };
 
 class ConsoleOutput : public CallBackObj {
   public:
-    ConsoleOutput(char *writeFile, CallBackObj *toCall);
+    ConsoleOutput(char *writeFile, CallBackObj *toCall, int bufferSize = 1);
 				// initialize hardware console output 
     ~ConsoleOutput();		// clean up console emulation
-    void PutInt(int number);
+    void PutInt(int number);	// Write "number" to the display, by 
+				// itself; the device must be idle
     void PutChar(char ch);	// Write "ch" to the console display, 
 				// and return immediately.  "callWhenDone" 
 				// will called when the I/O completes. 
-    void CallBack();		// Invoked when next character can be put
-				// out to the display.
+				// There must be room in the buffer.
+    int PutChars(char *data, int n);
+				// Put as many of the "n" characters as
+				// there is room for, and return how many
+    bool IsIdle() { return !putBusy; }
+				// Is the buffer empty, and the line free?
+    void CallBack();		// Invoked when a burst has gone out 
+				// to the display.
 
   private:
     int writeFileNo;			// UNIX file emulating the display
     CallBackObj *callWhenDone;		// Interrupt handler to call when 
-					// the next char can be put 
-    bool putBusy;    			// Is a PutChar operation in progress?
-					// If so, you can't do another one!
+					// there is room in the buffer
+    bool putBusy;    			// Is a burst in progress?
+    char *buffer;			// the characters waiting to go out,
+					// the current burst first
+    int bufferSize;			// # of characters "buffer" holds
+    int numBuffered;			// # of characters in it now
+    int burstSize;			// # of them in the current burst, or
+					// 0 if it is a PutInt
+
+    void StartBurst();			// send out the buffer
 };
 
 #endif // CONSOLE_H
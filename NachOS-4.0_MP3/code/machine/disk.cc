@@ -127,6 +127,7 @@ Disk::ReadRequest(int sectorNumber, char* data)
     active = TRUE;
     UpdateLast(sectorNumber);
     kernel->stats->numDiskReads++;
+    kernel->TraceDevice(TraceDiskStart, FALSE, sectorNumber);
     kernel->interrupt->Schedule(this, ticks, DiskInt);
 }
 
@@ -147,6 +148,7 @@ Disk::WriteRequest(int sectorNumber, char* data)
     active = TRUE;
     UpdateLast(sectorNumber);
     kernel->stats->numDiskWrites++;
+    kernel->TraceDevice(TraceDiskStart, TRUE, sectorNumber);
     kernel->interrupt->Schedule(this, ticks, DiskInt);
 }
 
@@ -159,6 +161,7 @@ void
 Disk::CallBack ()
 { 
     active = FALSE;
+    kernel->TraceDevice(TraceDiskDone);
     callWhenDone->CallBack();
 }
 
@@ -29,7 +29,7 @@
 static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
 			"console read", "network send", 
-			"network recv"};
+			"network recv", "job arrival"};
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -72,7 +72,7 @@ PendingCompare (PendingInterrupt *x, PendingInterrupt *y)
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new SortedList<PendingInterrupt *>(PendingCompare);
+    pending = new SkipList<PendingInterrupt *>(PendingCompare);
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -149,18 +149,33 @@ Interrupt::OneTick()
 {
     MachineStatus oldStatus = status;
     Statistics *stats = kernel->stats;
+    Cpu *cpu = kernel->currentCpu;
+    int tick = (status == SystemMode) ? SystemTick : UserTick;
 
 // advance simulated time
-    if (status == SystemMode) {
-        stats->totalTicks += SystemTick;
+    if (status == SystemMode)
 	stats->systemTicks += SystemTick;
-    } else {
-	stats->totalTicks += UserTick;
+    else
 	stats->userTicks += UserTick;
+    if (kernel->numCpus == 1)
+	stats->totalTicks += tick;
+    else {
+    // advance the current CPU's clock; simulated time only moves on
+    // once every busy CPU has caught up (cf. cpu.h)
+	cpu->clock = max(cpu->clock, stats->totalTicks) + tick;
+	cpu->busyTicks += tick;
+	stats->totalTicks = max(stats->totalTicks, 
+					kernel->scheduler->CpuTime());
     }
-    while (kernel->initTime[kernel->listCounter] < stats->totalTicks && kernel->listCounter < kernel->totalList) {
-        kernel->listCounter++;
-        kernel->Exec(kernel->jobName[kernel->listCounter-1]);
+    if (kernel->scheduler->SlicesByClock()) {
+    // time slices are kept by the CPU's clock, not the timer
+	int now = (kernel->numCpus == 1) ? stats->totalTicks : cpu->clock;
+
+	if (now >= cpu->sliceEnd) {	// time slice is up
+	    cpu->sliceEnd = now 
+		+ kernel->scheduler->TimeSlice(kernel->currentThread);
+	    yieldOnReturn = TRUE;
+	}
     }
     DEBUG(dbgInt, "== Tick " << stats->totalTicks << " ==");
 
@@ -177,6 +192,14 @@ Interrupt::OneTick()
 	kernel->currentThread->Yield();
 	status = oldStatus;
     }
+    if (kernel->numCpus > 1) {	// give the other CPUs a turn
+	ChangeLevel(IntOn, IntOff);
+	kernel->currentCpu->userMode = (oldStatus == UserMode);
+	status = SystemMode;
+	kernel->scheduler->NextCpu();
+	status = oldStatus;
+	ChangeLevel(IntOff, IntOn);
+    }
 }
 
 //----------------------------------------------------------------------
@@ -213,6 +236,8 @@ Interrupt::Idle()
 {
     DEBUG(dbgInt, "Machine idling; checking for interrupts.");
     status = IdleMode;
+    if (kernel->tickless)
+	kernel->alarm->Pause();	// go straight to the next real event
     if (CheckIfDue(TRUE)) {	// check for any pending interrupts
 	status = SystemMode;
 	return;			// return in case there's now
@@ -239,6 +264,10 @@ Interrupt::Halt()
 {
     cout << "Machine halting!\n\n";
     kernel->stats->Print();
+    kernel->scheduler->PrintStats();
+    if (kernel->numCpus > 1)
+	for (int i = 0; i < kernel->numCpus; i++)
+	    kernel->cpus[i]->Print();
     delete kernel;	// Never returns.
 }
 void
@@ -273,6 +302,54 @@ Interrupt::Schedule(CallBackObj *toCall, int fromNow, IntType type)
     pending->Insert(toOccur);
 }
 
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Remove every pending interrupt that would call "toCall", as if
+//	the device had been switched off before they occurred.
+//
+//	"toCall" is the object whose interrupts are no longer wanted
+//----------------------------------------------------------------------
+
+void
+Interrupt::Cancel(CallBackObj *toCall)
+{
+    PendingInterrupt *found;
+
+    do {			// start over after each removal
+	SkipListIterator<PendingInterrupt *> iter(pending);
+
+	found = NULL;
+	for (; !iter.IsDone(); iter.Next())
+	    if (iter.Item()->callOnInterrupt == toCall) {
+		found = iter.Item();
+		break;
+	    }
+	if (found != NULL) {
+	    DEBUG(dbgInt, "Cancelling interrupt handler the " 
+			<< intTypeNames[found->type] << " at time = " 
+			<< found->when);
+	    pending->Remove(found);
+	    delete found;
+	}
+    } while (found != NULL);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::NextDue
+// 	Return the time at which the next pending interrupt is due, or
+//	-1 if nothing is scheduled.  Until then, nothing can happen that
+//	user code running on the CPUs needs to know about (cf. 
+//	RunCpusAhead).
+//----------------------------------------------------------------------
+
+int
+Interrupt::NextDue()
+{
+    if (pending->IsEmpty())
+	return -1;
+    return pending->Front()->when;
+}
+
 //----------------------------------------------------------------------
 // Interrupt::CheckIfDue
 // 	Check if any interrupts are scheduled to occur, and if so, 
@@ -322,6 +399,7 @@ Interrupt::CheckIfDue(bool advanceClock)
     inHandler = TRUE;
     do {
         next = pending->RemoveFront();    // pull interrupt off list
+	kernel->TraceDevice(TraceInterrupt, next->type);
         next->callOnInterrupt->CallBack();// call the interrupt handler
 	delete next;
     } while (!pending->IsEmpty() 
@@ -49,7 +49,7 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 // In Nachos, we support a hardware timer device, a disk, a console
 // display and keyboard, and a network.
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-			NetworkSendInt, NetworkRecvInt};
+			NetworkSendInt, NetworkRecvInt, JobArrivalInt};
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
@@ -66,6 +66,11 @@ class PendingInterrupt {
     
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+
+    void *operator new(size_t size)	// from a free list, since 
+	{ return FreeList<PendingInterrupt>::Alloc(); }	// interrupts are
+    void operator delete(void *p)		// scheduled all the time
+	{ FreeList<PendingInterrupt>::Free(p); }
 };
 
 // The following class defines the data structures for the simulation
@@ -116,12 +121,18 @@ class Interrupt {
     				// Schedule an interrupt to occur
 				// at time "when".  This is called
     				// by the hardware device simulators.
+    void Cancel(CallBackObj *callTo);
+				// Take back the interrupts scheduled
+				// for "callTo"
     
     void OneTick();       	// Advance simulated time
 
+    int NextDue();		// When the next pending interrupt is
+				// due, or -1 if there is none
+
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    SortedList<PendingInterrupt *> *pending;		
+    SkipList<PendingInterrupt *> *pending;		
     				// the list of interrupts scheduled
 				// to occur in the future
     bool inHandler;		// TRUE if we are running an interrupt handler
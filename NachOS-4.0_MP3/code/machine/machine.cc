@@ -50,17 +50,27 @@ void CheckEndian()
 //
 //	"debug" -- if TRUE, drop into the debugger after each user instruction
 //		is executed.
+//	"memory" -- main memory of another Machine, to share, or NULL.
+//		A CPU that runs ahead on a host thread (cf. cpu.h) has
+//		its own registers but the same memory as kernel->machine.
 //----------------------------------------------------------------------
 
-Machine::Machine(bool debug)
+Machine::Machine(bool debug, char *memory)
 {
     int i;
 
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
-    mainMemory = new char[MemorySize];
-    for (i = 0; i < MemorySize; i++)
-      	mainMemory[i] = 0;
+    ownMemory = (memory == NULL);
+    if (ownMemory) {
+	mainMemory = new char[MemorySize];
+	for (i = 0; i < MemorySize; i++)
+	    mainMemory[i] = 0;
+    } else
+	mainMemory = memory;
+    deferExceptions = FALSE;
+    pendingException = NoException;
+    pendingVAddr = 0;
 #ifdef USE_TLB
     tlb = new TranslationEntry[TLBSize];
     for (i = 0; i < TLBSize; i++)
@@ -82,7 +92,8 @@ Machine::Machine(bool debug)
 
 Machine::~Machine()
 {
-    delete [] mainMemory;
+    if (ownMemory)
+	delete [] mainMemory;
     if (tlb != NULL)
         delete [] tlb;
 }
@@ -100,6 +111,11 @@ Machine::~Machine()
 void
 Machine::RaiseException(ExceptionType which, int badVAddr)
 {
+    if (deferExceptions) {	// running ahead, outside the kernel:
+	pendingException = which;	// leave it for the caller
+	pendingVAddr = badVAddr;
+	return;
+    }
     DEBUG(dbgMach, "Exception: " << exceptionNames[which]);
     registers[BadVAddrReg] = badVAddr;
     DelayedLoad(0, 0);			// finish anything in progress
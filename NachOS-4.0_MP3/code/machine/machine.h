@@ -93,13 +93,25 @@ class Interrupt;
 
 class Machine {
   public:
-    Machine(bool debug);	// Initialize the simulation of the hardware
-				// for running user programs
+    Machine(bool debug, char *memory = NULL);
+				// Initialize the simulation of the hardware
+				// for running user programs; if "memory"
+				// is given, share it instead of having
+				// our own
     ~Machine();			// De-allocate the data structures
 
 // Routines callable by the Nachos kernel
     void Run();	 		// Run a user program
 
+    int RunAhead(int count);	// Run up to "count" instructions without
+				// advancing simulated time, stopping
+				// short of the first exception; return
+				// # of instructions run.  Safe to call
+				// from a host thread (cf. cpu.h)
+    ExceptionType PendingException(int *badVAddr);
+				// the exception that stopped RunAhead,
+				// if any
+
     int ReadRegister(int num);	// read the contents of a CPU register
 
     void WriteRegister(int num, int value);
@@ -173,6 +185,12 @@ class Machine {
 
     int registers[NumTotalRegs]; // CPU registers, for executing user programs
 
+    bool ownMemory;		// did we allocate mainMemory?
+    bool deferExceptions;	// record exceptions instead of raising
+				// them (while running ahead)
+    ExceptionType pendingException;
+    int pendingVAddr;		// the last exception recorded
+
     bool singleStep;		// drop back into the debugger after each
 				// simulated instruction
     int runUntilTime;		// drop back into the debugger when simulated
@@ -64,13 +64,71 @@ Machine::Run()
     }
     kernel->interrupt->setStatus(UserMode);
     for (;;) {
-        OneInstruction(instr);
-		kernel->interrupt->OneTick();
-		if (singleStep && (runUntilTime <= kernel->stats->totalTicks))
-	  		Debugger();
+	Cpu *cpu = kernel->currentCpu;
+
+	if (kernel->parallelCpus)
+	    RunCpusAhead();
+	if (cpu->pendingException != NoException) {
+	    ExceptionType which = cpu->pendingException;
+
+	    // the instruction we stopped short of, when running ahead
+	    cpu->pendingException = NoException;
+	    RaiseException(which, cpu->pendingVAddr);
+	} else
+	    OneInstruction(instr);
+	kernel->interrupt->OneTick();
+	if (singleStep && (runUntilTime <= kernel->stats->totalTicks))
+	    Debugger();
     }
 }
 
+//----------------------------------------------------------------------
+// Machine::RunAhead
+// 	Execute up to "count" instructions of a user-level program,
+//	without advancing simulated time or checking for interrupts --
+//	the caller accounts for the time, and makes sure that no 
+//	interrupt can be due in the meantime.
+//
+//	The instruction that raises an exception (including a system
+//	call) is not run: it is recorded instead (cf. PendingException),
+//	since the kernel can't be entered from here.  So this only 
+//	touches our registers, page table and memory, and can run on a 
+//	host thread, alongside other Machines sharing the same memory.
+//
+//	Returns the number of instructions that ran to completion.
+//----------------------------------------------------------------------
+
+int
+Machine::RunAhead(int count)
+{
+    Instruction instr;		// storage for decoded instruction
+    int done;
+
+    deferExceptions = TRUE;
+    pendingException = NoException;
+    for (done = 0; done < count; done++) {
+	OneInstruction(&instr);
+	if (pendingException != NoException)
+	    break;
+    }
+    deferExceptions = FALSE;
+    return done;
+}
+
+//----------------------------------------------------------------------
+// Machine::PendingException
+// 	Return the exception that stopped the last RunAhead, or 
+//	NoException if it ran to the end; "badVAddr" is set to the 
+//	address that caused it.
+//----------------------------------------------------------------------
+
+ExceptionType
+Machine::PendingException(int *badVAddr)
+{
+    *badVAddr = pendingVAddr;
+    return pendingException;
+}
+
 
 //----------------------------------------------------------------------
 // TypeToReg
@@ -59,6 +59,38 @@ Timer::CallBack()
     			// decide if it wants to disable future interrupts
 }
 
+//----------------------------------------------------------------------
+// Timer::Enable
+//      Turn the timer device back on, after Disable.  Since the timer
+//	is only ever disabled from its own interrupt handler (before the
+//	next interrupt is scheduled), no interrupt is pending, and we 
+//	schedule one.
+//----------------------------------------------------------------------
+
+void
+Timer::Enable()
+{
+    if (disable) {
+	disable = FALSE;
+	SetInterrupt();
+    }
+}
+
+//----------------------------------------------------------------------
+// Timer::Stop
+//      Turn the timer device off right away: unlike Disable, the
+//	interrupt already scheduled doesn't happen either.
+//----------------------------------------------------------------------
+
+void
+Timer::Stop()
+{
+    if (!disable) {
+	kernel->interrupt->Cancel(this);
+	disable = TRUE;
+    }
+}
+
 //----------------------------------------------------------------------
 // Timer::SetInterrupt
 //      Cause a timer interrupt to occur in the future, unless
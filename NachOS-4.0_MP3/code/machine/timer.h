@@ -35,6 +35,9 @@ class Timer : public CallBackObj {
     void Disable() { disable = TRUE; }
     				// Turn timer device off, so it doesn't
 				// generate any more interrupts.
+    void Enable();		// Turn it back on
+    void Stop();		// Turn it off now, taking back the
+				// interrupt already scheduled
 
   private:
     bool randomize;		// set if we need to use a random timeout delay
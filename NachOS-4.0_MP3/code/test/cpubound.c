@@ -0,0 +1,8 @@
+#include "syscall.h"
+
+int
+main()
+{
+    int i;
+    for (i=0;i<5000;i++);
+}
@@ -0,0 +1,11 @@
+#include "syscall.h"
+
+int
+main()
+{
+    int i,j;
+    for (i=0;i<10;i++){
+	for(j=0;j<20;j++);
+	PrintInt(i);
+    }
+}
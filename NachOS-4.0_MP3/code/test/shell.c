@@ -6,7 +6,7 @@ main()
     SpaceId newProc;
     OpenFileId input = ConsoleInput;
     OpenFileId output = ConsoleOutput;
-    char prompt[2], ch, buffer[60];
+    char prompt[2], buffer[60];
     int i;
 
     prompt[0] = '-';
@@ -16,15 +16,13 @@ main()
     {
 	Write(prompt, 2, output);
 
-	i = 0;
-	
-	do {
-	
-	    Read(&buffer[i], 1, input); 
+	i = Read(buffer, 59, input);	/* a whole line at a time */
+	if( i <= 0 )
+		Halt();			/* end of input */
 
-	} while( buffer[i++] != '\n' );
-
-	buffer[--i] = '\0';
+	if( buffer[i - 1] == '\n' )
+		i--;
+	buffer[i] = '\0';
 
 	if( i > 0 ) {
 		newProc = Exec(buffer);
@@ -32,4 +30,3 @@ main()
 	}
     }
 }
-
@@ -41,6 +41,15 @@ Alarm::Alarm(bool doRandom)
 //
 //	For now, just provide time-slicing.  Only need to time slice 
 //      if we're currently running something (in other words, not idle).
+//	If idle, with nothing ready to run (another interrupt handler
+//	may have just made a thread ready), turn the timer off, so that
+//	Nachos can halt once nothing else is pending; Resume turns it 
+//	back on.
+//
+//	With -tickless, the timer is also turned off whenever it has no
+//	time slice to end: when no other thread is waiting for the CPU,
+//	or when time slices are kept by the CPUs' clocks instead.  The
+//	scheduler turns it back on when a thread becomes ready.
 //----------------------------------------------------------------------
 
 void 
@@ -49,9 +58,15 @@ Alarm::CallBack()
     Interrupt *interrupt = kernel->interrupt;
     MachineStatus status = interrupt->getStatus();
     
-    if (status != IdleMode) {
-	interrupt->YieldOnReturn();
-    }else{
+    if (kernel->tickless && (kernel->scheduler->SlicesByClock() 
+			|| kernel->scheduler->NumReady() == 0)) {
+        this->timer->Disable();
+    } else if (status != IdleMode) {
+	if (!kernel->scheduler->SlicesByClock())
+	    interrupt->YieldOnReturn();	// otherwise, each CPU is time
+					// sliced by its own clock, cf.
+					// Interrupt::OneTick
+    }else if (kernel->scheduler->NumReady() == 0) {
         this->timer->Disable();
     }
 }
@@ -31,6 +31,12 @@ class Alarm : public CallBackObj {
     
     void WaitUntil(int x);	// suspend execution until time > now + x
                                 // this method is not yet implemented
+    void Resume() { timer->Enable(); }
+				// There is work again, after the timer
+				// was turned off while idle
+    void Pause() { timer->Stop(); }
+				// Nothing to time slice for now 
+				// (-tickless)
 
   private:
     Timer *timer;		// the hardware timer device
@@ -0,0 +1,160 @@
+// cpu.cc 
+//	Routines to keep track of the state of a simulated CPU.  Most of
+//	the work of simulating several CPUs is done by the scheduler
+//	(cf. scheduler.cc) and Interrupt::OneTick.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "cpu.h"
+#include "main.h"
+
+//----------------------------------------------------------------------
+// Cpu::Cpu
+// 	Initialize a simulated CPU, with nothing to run.
+//
+//	"cpuID" is the index of the CPU in kernel->cpus
+//----------------------------------------------------------------------
+
+Cpu::Cpu(int cpuID)
+{
+    id = cpuID;
+    running = NULL;
+    clock = 0;
+    sliceEnd = TimerTicks;
+    busyTicks = 0;
+    userMode = FALSE;
+    machine = NULL;
+    ahead = 0;
+    pendingException = NoException;
+    pendingVAddr = 0;
+}
+
+//----------------------------------------------------------------------
+// Cpu::~Cpu
+// 	De-allocate the registers used to run ahead, if any.
+//----------------------------------------------------------------------
+
+Cpu::~Cpu()
+{
+    if (machine != NULL)
+	delete machine;
+}
+
+//----------------------------------------------------------------------
+// Cpu::RunAhead
+// 	Run the user program loaded into "machine" for up to "ahead"
+//	instructions, and note how many ran, and why we stopped.  Called 
+//	on a host thread: so this mustn't touch anything but the CPU's 
+//	own state (cf. Machine::RunAhead).
+//----------------------------------------------------------------------
+
+void
+Cpu::RunAhead()
+{
+    ahead = machine->RunAhead(ahead);
+    pendingException = machine->PendingException(&pendingVAddr);
+}
+
+//----------------------------------------------------------------------
+// RunAheadOn
+// 	Dummy function, because RunOnHostThreads needs a plain function.
+//----------------------------------------------------------------------
+
+static void
+RunAheadOn(void *cpu)
+{
+    ((Cpu *) cpu)->RunAhead();
+}
+
+//----------------------------------------------------------------------
+// RunCpusAhead
+// 	With the -par flag, called before each user instruction: let 
+//	every CPU that is running a user program run ahead of simulated
+//	time, each on its own host thread.
+//
+//	This is a conservative parallel simulation.  CPUs running user
+//	code can't affect each other (their memory is disjoint), so they
+//	only need to be in step when the kernel runs: at an interrupt
+//	(including a job arrival), the end of a time slice, or an
+//	exception.  Each CPU runs up to the tick before the next
+//	interrupt, or before its slice ends, or up to its next
+//	exception, whichever comes first.  Then we are back to
+//	simulating one CPU at a time, to deal with whatever comes next.
+//	How far each CPU gets only depends on simulated state, never on
+//	the host, so every run of the same workload comes out the same.
+//
+//	The running thread of the current CPU has its registers in
+//	kernel->machine; those of the other CPUs are parked.
+//----------------------------------------------------------------------
+
+void
+RunCpusAhead()
+{
+    Statistics *stats = kernel->stats;
+    Cpu *cpu, *current = kernel->currentCpu;
+    Thread *thread[MaxCpus];
+    void *ahead[MaxCpus];
+    int numAhead = 0, horizon, limit, start;
+
+    horizon = kernel->interrupt->NextDue();
+    for (int i = 0; i < kernel->numCpus; i++) {
+	cpu = kernel->cpus[i];
+	if (cpu->pendingException != NoException)
+	    continue;
+	limit = cpu->sliceEnd;
+	if (horizon >= 0)
+	    limit = min(limit, horizon);
+	start = max(cpu->clock, stats->totalTicks);
+	cpu->ahead = (limit - 1 - start) / UserTick;
+	if (cpu->ahead < MinRunAhead)
+	    continue;
+	if (cpu == current)
+	    thread[numAhead] = kernel->currentThread;
+	else if (cpu->running != NULL && cpu->userMode)
+	    thread[numAhead] = cpu->running;
+	else
+	    continue;
+	ASSERT(thread[numAhead]->space != NULL);
+	if (cpu == current)
+	    kernel->currentThread->SaveUserState();
+	thread[numAhead]->RestoreUserState(cpu->machine);
+	thread[numAhead]->space->RestoreState(cpu->machine);
+	ahead[numAhead++] = cpu;
+    }
+    if (numAhead == 0)
+	return;
+
+    if (numAhead == 1)			// no need to wake anyone up
+	RunAheadOn(ahead[0]);
+    else
+	RunOnHostThreads(RunAheadOn, ahead, numAhead);
+
+    for (int i = 0; i < numAhead; i++) {
+	cpu = (Cpu *) ahead[i];
+	thread[i]->SaveUserState(cpu->machine);
+	if (cpu == current)
+	    kernel->currentThread->RestoreUserState();
+	if (cpu->ahead > 0) {
+	    cpu->clock = max(cpu->clock, stats->totalTicks) 
+					+ cpu->ahead * UserTick;
+	    cpu->busyTicks += cpu->ahead * UserTick;
+	    stats->userTicks += cpu->ahead * UserTick;
+	}
+    }
+    stats->totalTicks = max(stats->totalTicks, kernel->scheduler->CpuTime());
+}
+
+//----------------------------------------------------------------------
+// Cpu::Print
+// 	Print how busy the CPU has been.
+//----------------------------------------------------------------------
+
+void
+Cpu::Print()
+{
+    cout << "CPU " << id << ": busy " << busyTicks << " of " 
+	<< kernel->stats->totalTicks << " ticks\n";
+}
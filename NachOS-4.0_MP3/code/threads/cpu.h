@@ -0,0 +1,72 @@
+// cpu.h 
+//	Data structures for simulating a multiprocessor.
+//
+//	With the -smp flag, Nachos simulates several CPUs sharing one
+//	memory.  Only one of them executes at any moment (the host
+//	runs a single Nachos thread at a time), but each one keeps its
+//	own clock, and the kernel switches to whichever CPU is furthest
+//	behind after every tick.  Simulated time ("totalTicks") is the
+//	clock of the CPU that is furthest behind, so N busy CPUs get N
+//	ticks of work done per tick of simulated time.
+//
+//	The running thread of the CPU being simulated is
+//	kernel->currentThread, and its registers are in kernel->machine.
+//	The running thread of every other CPU is parked (as if it had
+//	been switched out by a context switch) until its CPU's turn
+//	comes around again.
+//
+//	Each CPU has its own ready queue (cf. scheduler.h).
+//
+//	With the -par flag as well, the CPUs that are running user 
+//	programs also take turns at running ahead, all at once, each on 
+//	its own host thread (cf. RunCpusAhead).
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef CPU_H
+#define CPU_H
+
+#include "copyright.h"
+#include "machine.h"
+
+#define MaxCpus		8		// most CPUs we can simulate
+#define MinRunAhead	16		// don't bother running a CPU ahead
+					// for fewer instructions than this
+
+class Thread;
+
+// The following class defines the state of one simulated CPU.
+
+class Cpu {
+  public:
+    Cpu(int cpuID);			// Initialize an idle CPU
+    ~Cpu();
+
+    int id;				// index in kernel->cpus
+    Thread *running;			// thread parked on this CPU while
+					// another CPU is simulated; NULL if
+					// the CPU is idle (or is the current
+					// one)
+    int clock;				// local time, in ticks
+    int sliceEnd;			// time slice of the running thread
+					// ends at this (local) time
+    int busyTicks;			// time spent running threads
+    bool userMode;			// was "running" parked while it was 
+					// running user code?
+
+    Machine *machine;			// registers, to run ahead (-par)
+    int ahead;				// # of instructions to run ahead, and 
+					// then # that actually ran
+    ExceptionType pendingException;	// where running ahead stopped; to be
+    int pendingVAddr;			// raised when the CPU's turn comes
+
+    void RunAhead();			// Run ahead (on a host thread)
+    void Print();			// Print per-CPU statistics
+};
+
+extern void RunCpusAhead();		// Run every CPU running user code 
+					// ahead, in parallel
+
+#endif // CPU_H
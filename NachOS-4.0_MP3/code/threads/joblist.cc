@@ -0,0 +1,246 @@
+// joblist.cc
+//	Routines to read the list of jobs to run with --test, one job
+//	at a time.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "joblist.h"
+#include "debug.h"
+#include "main.h"
+#include <math.h>
+
+// Programs run by generated jobs, half and half
+#define NumGenPrograms 2
+static const char *genPrograms[NumGenPrograms] = { "cpubound", "iobound" };
+
+//----------------------------------------------------------------------
+// JobList::JobList
+// 	Open the list of jobs, read in the first one, and schedule its
+//	arrival.
+//
+//	"fileName" -- UNIX file holding the list
+//----------------------------------------------------------------------
+
+JobList::JobList(const char *fileName)
+{
+    names = new List<char *>;
+    generating = FALSE;
+    numLeft = 0;
+    nextName = NULL;
+    file.open(fileName, ios::in);
+    if (!file) {
+	cout << "Fail to open file JobList" << endl;
+	return;
+    }
+    file >> numLeft;
+    ReadJob();
+    ScheduleArrival();
+}
+
+//----------------------------------------------------------------------
+// JobList::JobList
+// 	Set up a synthetic workload, make its first job, and schedule its
+//	arrival.
+//
+//	"seed" -- seed for the workload's random numbers (kept apart
+//		from those of -rs, so the workload is the same either way)
+//	"numJobs" -- how many jobs to make
+//	"gap" -- mean time between arrivals, in ticks
+//----------------------------------------------------------------------
+
+JobList::JobList(unsigned int seed, int numJobs, int gap)
+{
+    ASSERT(numJobs >= 0 && gap > 0);
+    names = new List<char *>;
+    generating = TRUE;
+    randomState = (seed == 0) ? 1 : seed;	// xorshift can't start at 0
+    numLeft = numJobs;
+    meanGap = gap;
+    genTime = 0;
+    nextName = NULL;
+    MakeJob();
+    ScheduleArrival();
+}
+
+//----------------------------------------------------------------------
+// JobList::~JobList
+// 	Close the list, and de-allocate the program names.
+//----------------------------------------------------------------------
+
+JobList::~JobList()
+{
+    while (!names->IsEmpty())
+	delete [] names->RemoveFront();
+    delete names;
+}
+
+//----------------------------------------------------------------------
+// JobList::ReadJob
+// 	Read the line for the next job, "<arrival time>,<program>", or
+//	"<arrival time>,<program>,<priority>".  If there are no more (or
+//	the line is garbled), the list is empty.
+//----------------------------------------------------------------------
+
+void
+JobList::ReadJob()
+{
+    char line[JobLineSize];
+    char *time, *name, *priority;
+
+    nextName = NULL;
+    if (numLeft == 0)
+	return;
+    numLeft--;
+    file.width(JobLineSize);
+    if (!(file >> line)) {
+	numLeft = 0;
+	return;
+    }
+    time = strtok(line, ",");
+    name = strtok(NULL, ",");
+    if (time == NULL || name == NULL) {
+	numLeft = 0;
+	return;
+    }
+    priority = strtok(NULL, ",");
+    nextTime = atoi(time);
+    nextName = Intern(name);
+    nextPriority = (priority == NULL) ? 0 : atoi(priority);
+}
+
+//----------------------------------------------------------------------
+// JobList::Uniform
+// 	Return a pseudo-random number in [0, 1), from a xorshift 
+//	generator.
+//----------------------------------------------------------------------
+
+double
+JobList::Uniform()
+{
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return (randomState >> 8) / 16777216.0;	// top 24 bits
+}
+
+//----------------------------------------------------------------------
+// JobList::MakeJob
+// 	Make up the next job of a synthetic workload.  The gap since the
+//	last arrival is exponentially distributed, so arrivals form a
+//	Poisson process.
+//----------------------------------------------------------------------
+
+void
+JobList::MakeJob()
+{
+    nextName = NULL;
+    if (numLeft == 0)
+	return;
+    numLeft--;
+    genTime += -meanGap * log(1 - Uniform());
+    nextTime = (int) genTime;
+    nextName = Intern(genPrograms[Uniform() < 0.5 ? 0 : 1]);
+    nextPriority = (int) (Uniform() * (MaxJobPriority + 1));
+}
+
+//----------------------------------------------------------------------
+// JobList::ProgramsExist
+// 	Return TRUE if the programs run by generated jobs can be opened.
+//	If not, every job would fail to load and finish at once, and the
+//	workload's metrics would measure nothing.
+//----------------------------------------------------------------------
+
+bool
+JobList::ProgramsExist()
+{
+    OpenFile *executable;
+
+    for (int i = 0; i < NumGenPrograms; i++) {
+	executable = kernel->fileSystem->Open(Intern(genPrograms[i]));
+	if (executable == NULL) {
+	    cerr << "Unable to open file " << genPrograms[i] << "\n";
+	    return FALSE;
+	}
+	delete executable;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// JobList::Intern
+// 	Return the copy of "name" kept for every job running that
+//	program, making one if this is the first.  Threads keep a
+//	pointer to their name, so it has to outlive the job.
+//----------------------------------------------------------------------
+
+char *
+JobList::Intern(const char *name)
+{
+    ListIterator<char *> iter(names);
+    char *copy;
+
+    for (; !iter.IsDone(); iter.Next()) {
+	if (strcmp(iter.Item(), name) == 0)
+	    return iter.Item();
+    }
+    copy = new char[strlen(name) + 1];
+    strcpy(copy, name);
+    names->Append(copy);
+    return copy;
+}
+
+//----------------------------------------------------------------------
+// JobList::Remove
+// 	Take the next job off the list, and return the program it runs.
+//----------------------------------------------------------------------
+
+char *
+JobList::Remove()
+{
+    char *name = nextName;
+
+    ASSERT(!IsEmpty());
+    NextJob();
+    return name;
+}
+
+//----------------------------------------------------------------------
+// JobList::ScheduleArrival
+// 	Schedule an interrupt for the tick after the next job's arrival
+//	time (a job is started once its arrival time has passed), if
+//	there is a next job.
+//----------------------------------------------------------------------
+
+void
+JobList::ScheduleArrival()
+{
+    int now = kernel->stats->totalTicks;
+
+    if (!IsEmpty())
+	kernel->interrupt->Schedule(this, max(nextTime + 1 - now, 1),
+					JobArrivalInt);
+}
+
+//----------------------------------------------------------------------
+// JobList::CallBack
+// 	Interrupt handler for a job arrival.  Start every job whose
+//	arrival time has passed (several jobs can arrive at once), then
+//	schedule the next arrival.  If the CPUs were idle, the timer may
+//	have been turned off; turn it back on, to time slice the jobs.
+//----------------------------------------------------------------------
+
+void
+JobList::CallBack()
+{
+    int priority;
+
+    while (!IsEmpty() && nextTime < kernel->stats->totalTicks) {
+	priority = nextPriority;
+	kernel->Exec(Remove(), priority);
+    }
+    kernel->alarm->Resume();
+    ScheduleArrival();
+}
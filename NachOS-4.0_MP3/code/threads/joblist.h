@@ -0,0 +1,96 @@
+// joblist.h
+//	Data structures for the list of jobs to run with --test, -jobs
+//	or -gen.
+//
+//	A job file ("JobList" for --test) gives the number of jobs, then
+//	one line per job, in order of arrival:
+//
+//		3
+//		0,test1
+//		30,test2
+//		45,cpubound,120
+//
+//	meaning that "test1" is to be started after tick 0, "test2"
+//	after tick 30, and "cpubound" after tick 45, at priority 120 (the
+//	priority is 0 if not given).  The file is read one job at a
+//	time, as the jobs are started, so a list of any length -- say, a
+//	trace of arrivals from a real system -- takes the same memory.
+//	Jobs running the same program share one copy of its name.
+//
+//	Instead of reading a file, the list can make up a synthetic
+//	workload: jobs arriving as a Poisson process (exponentially
+//	distributed gaps between arrivals), each running a CPU-bound or
+//	an I/O-bound program (test/cpubound, test/iobound), at a
+//	priority drawn evenly from all three bands.  The same seed gives
+//	the same workload.
+//
+//	The list behaves like a device: each arrival is an interrupt
+//	(JobArrivalInt), due on the tick after the job's arrival time,
+//	and starts every job due by then.  So nothing polls for jobs,
+//	and an idle CPU sleeps until the next one arrives.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef JOBLIST_H
+#define JOBLIST_H
+
+#include "copyright.h"
+#include "list.h"
+#include "callback.h"
+#include <fstream>
+
+#define JobLineSize	256		// longest line in the file
+#define MaxJobPriority	149		// generated priorities are 0..149
+
+// The following class defines a list of jobs waiting to arrive.
+
+class JobList : public CallBackObj {
+  public:
+    JobList(const char *fileName);	// open the list, and schedule
+					// the first arrival
+    JobList(unsigned int seed, int numJobs, int gap);
+					// generate "numJobs" jobs, arriving
+					// "gap" ticks apart on average
+    ~JobList();				// close it
+
+    void CallBack();			// start the jobs that have arrived
+    bool ProgramsExist();		// can generated jobs be loaded?
+
+    bool IsEmpty() { return (nextName == NULL); }
+					// have all the jobs arrived?
+    int NextArrival() {			// when the next one arrives
+	ASSERT(!IsEmpty());
+	return nextTime;
+    }
+
+  private:
+    ifstream file;			// the rest of the list
+    int numLeft;			// # of jobs left to read or make
+    int nextTime;			// arrival time of the next job
+    char *nextName;			// its program, or NULL if none
+    int nextPriority;			// and its priority
+    List<char *> *names;		// the programs seen so far
+
+    bool generating;			// making up jobs, not reading them?
+    unsigned int randomState;		// state of the generator
+    double meanGap;			// mean time between arrivals
+    double genTime;			// arrival time of the last job made
+
+    void NextJob() {			// read in or make the next job
+	if (generating) 
+	    MakeJob();
+	else 
+	    ReadJob();
+    }
+    void ReadJob();			// read in the next job
+    void MakeJob();			// make up the next job
+    double Uniform();			// random number in [0, 1)
+    char *Remove();			// take the next job off the list,
+					// and return its program name
+    void ScheduleArrival();		// interrupt when the next job is due
+    char *Intern(const char *name);	// the shared copy of "name"
+};
+
+#endif // JOBLIST_H
@@ -29,11 +29,29 @@
 Kernel::Kernel(int argc, char **argv)
 {
     randomSlice = FALSE; 
+    numCpus = 1;
+    parallelCpus = FALSE;
+    fairShare = FALSE;
+    minGranularity = MinGranularity;
+    wakeupGranularity = WakeupGranularity;
+    burstAlpha = 0.5;
+    srtf = FALSE;
+    tickless = FALSE;
+    traceFile = NULL;
+    traceBuffer = NULL;
+    processTable = NULL;
+    jobList = NULL;
+    jobFile = NULL;
+    genJobs = 0;
+    execFiles = new List<char *>;
+    execPriorities = new List<int>;
     debugUserProg = FALSE;
     consoleIn = NULL;          // default is stdin
     consoleOut = NULL;         // default is stdout
+    consoleBufferSize = 1;
 #ifndef FILESYS_STUB
     formatFlag = FALSE;
+    layout = PlainLayout;
 #endif
     reliability = 1;            // network reliability, default is 1.0
     hostName = 0;               // machine id, also UNIX socket name
@@ -47,35 +65,59 @@ Kernel::Kernel(int argc, char **argv)
 	    	i++;
         } else if (strcmp(argv[i], "-s") == 0) {
             debugUserProg = TRUE;
+        } else if (strcmp(argv[i], "-smp") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	numCpus = atoi(argv[i + 1]);
+	    	ASSERT(numCpus >= 1 && numCpus <= MaxCpus);
+	    	i++;
+        } else if (strcmp(argv[i], "-par") == 0) {
+	    	parallelCpus = TRUE;
+        } else if (strcmp(argv[i], "-cfs") == 0) {
+	    	fairShare = TRUE;
+        } else if (strcmp(argv[i], "-gran") == 0) {
+	    	ASSERT(i + 2 < argc);
+	    	minGranularity = atoi(argv[i + 1]);
+	    	wakeupGranularity = atoi(argv[i + 2]);
+	    	ASSERT(minGranularity > 0 && wakeupGranularity >= 0);
+	    	i += 2;
+        } else if (strcmp(argv[i], "-alpha") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	burstAlpha = atof(argv[i + 1]);
+	    	ASSERT(burstAlpha > 0 && burstAlpha <= 1);
+	    	i++;
+        } else if (strcmp(argv[i], "-srtf") == 0) {
+	    	srtf = TRUE;
+        } else if (strcmp(argv[i], "-tickless") == 0) {
+	    	tickless = TRUE;
+        } else if (strcmp(argv[i], "-trace") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	traceFile = argv[i + 1];
+	    	i++;
 		} else if (strcmp(argv[i], "-e") == 0) {
-        	execfile[++execfileNum]= argv[++i];
-		cout << execfile[execfileNum] << "\n";
-		priority[execfileNum] = 75;
+	    	ASSERT(i + 1 < argc);
+	    	execFiles->Append(argv[++i]);
+		cout << argv[i] << "\n";
+	    	execPriorities->Append(75);
 		} else if (strcmp(argv[i], "-ep") == 0) {
-        	execfile[++execfileNum]= argv[++i];
-		cout << execfile[execfileNum] << "\n";
-		priority[execfileNum] = atoi(argv[++i]);
+	    	ASSERT(i + 2 < argc);
+	    	execFiles->Append(argv[++i]);
+		cout << argv[i] << "\n";
+	    	execPriorities->Append(atoi(argv[++i]));
 		} else if (strcmp(argv[i], "--test") ==0 ) {
-                        fstream fp;
-                        fp.open("JobList", ios::in);
-                        if (!fp) {
-                                cout << "Fail to open file JobList" << endl;
-                        } else {
-                                if (!fp.eof()) {
-                                        fp >> totalList;
-                                }
-                                for (int i=0;i<totalList;i++) {
-                                        char line[100];
-                                        fp >> line;
-                                        char *substring;
-                                        char *delim=",";
-                                        substring = strtok(line, delim);
-                                        initTime[i] = atoi(substring);
-                                        substring = strtok(NULL, delim);
-                                        strcpy(jobName[i],substring);
-                                }
-                                fp.close();
-                        }
+	    	ASSERT(jobFile == NULL && genJobs == 0);  // one job source
+	    	jobFile = "JobList";
+		} else if (strcmp(argv[i], "-jobs") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	ASSERT(jobFile == NULL && genJobs == 0);
+	    	jobFile = argv[++i];
+		} else if (strcmp(argv[i], "-gen") == 0) {
+	    	ASSERT(i + 3 < argc);
+	    	ASSERT(jobFile == NULL && genJobs == 0);
+	    	genSeed = atoi(argv[i + 1]);
+	    	genJobs = atoi(argv[i + 2]);
+	    	genGap = atoi(argv[i + 3]);
+	    	ASSERT(genJobs > 0 && genGap > 0);
+	    	i += 3;
 		} else if (strcmp(argv[i], "-ci") == 0) {
 	    	ASSERT(i + 1 < argc);
 	    	consoleIn = argv[i + 1];
@@ -84,9 +126,18 @@ Kernel::Kernel(int argc, char **argv)
 	    	ASSERT(i + 1 < argc);
 	    	consoleOut = argv[i + 1];
 	    	i++;
+		} else if (strcmp(argv[i], "-cobuf") == 0) {
+	    	ASSERT(i + 1 < argc);
+	    	consoleBufferSize = atoi(argv[i + 1]);
+	    	ASSERT(consoleBufferSize >= 1);
+	    	i++;
 #ifndef FILESYS_STUB
 		} else if (strcmp(argv[i], "-f") == 0) {
 	    	formatFlag = TRUE;
+		} else if (strcmp(argv[i], "-J") == 0) {
+	    	layout = JournalLayout;
+		} else if (strcmp(argv[i], "-L") == 0) {
+	    	layout = LogLayout;
 #endif
         } else if (strcmp(argv[i], "-n") == 0) {
             ASSERT(i + 1 < argc);   // next argument is float
@@ -99,9 +150,14 @@ Kernel::Kernel(int argc, char **argv)
         } else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-rs randomSeed]\n";
 	   		cout << "Partial usage: nachos [-s]\n";
-            cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut]\n";
+	   		cout << "Partial usage: nachos [-smp #cpus [-par]]\n";
+	   		cout << "Partial usage: nachos [-cfs [-gran min wakeup]]\n";
+	   		cout << "Partial usage: nachos [-alpha weight] [-srtf] [-tickless]\n";
+	   		cout << "Partial usage: nachos [-trace traceFile]\n";
+	   		cout << "Partial usage: nachos [--test | -jobs jobFile | -gen seed #jobs meanGap]\n";
+            cout << "Partial usage: nachos [-ci consoleIn] [-co consoleOut] [-cobuf #chars]\n";
 #ifndef FILESYS_STUB
-	    	cout << "Partial usage: nachos [-nf]\n";
+	    	cout << "Partial usage: nachos [-nf] [-f [-J | -L]]\n";
 #endif
             cout << "Partial usage: nachos [-n #] [-m #]\n";
 		}
@@ -125,22 +181,48 @@ Kernel::Initialize()
 
     stats = new Statistics();		// collect statistics
     interrupt = new Interrupt;		// start up interrupt handling
+    if (traceFile != NULL)		// before the first thread is made
+	traceBuffer = new TraceBuffer(traceFile);
+    for (int i = 0; i < numCpus; i++)
+	cpus[i] = new Cpu(i);
+    currentCpu = cpus[0];		// we start out on CPU 0
     scheduler = new Scheduler();	// initialize the ready queue
+    processTable = new ProcessTable();
+    currentThread = new Thread("main", processTable->NewPid());
+    processTable->Insert(currentThread);
+    if (jobFile != NULL)		// schedules the first arrival
+	jobList = new JobList(jobFile);
+    else if (genJobs > 0)
+	jobList = new JobList(genSeed, genJobs, genGap);
+    currentThread->setStatus(RUNNING);	// before anything that might
+					// have to wait, eg, for the disk
+    if (traceBuffer != NULL)		// start main's span (the text 
+	Trace(TraceRunning, currentThread, JUST_CREATED, RUNNING);
+					// trace never showed this)
     alarm = new Alarm(randomSlice);	// start up time slicing
     machine = new Machine(debugUserProg);
+    if (numCpus == 1)
+	parallelCpus = FALSE;		// nothing to run in parallel
+    if (parallelCpus) {			// each CPU gets its own registers,
+	ASSERT(machine->tlb == NULL);	// to run ahead on a host thread
+	for (int i = 0; i < numCpus; i++)
+	    cpus[i]->machine = new Machine(FALSE, machine->mainMemory);
+	StartHostThreads(numCpus - 1);
+    }
     synchConsoleIn = new SynchConsoleInput(consoleIn); // input from stdin
-    synchConsoleOut = new SynchConsoleOutput(consoleOut); // output to stdout
+    synchConsoleOut = new SynchConsoleOutput(consoleOut, consoleBufferSize);
     synchDisk = new SynchDisk();    //
 #ifdef FILESYS_STUB
     fileSystem = new FileSystem();
 #else
-    fileSystem = new FileSystem(formatFlag);
+    openFileTable = new OpenFileTable();
+    fileSystem = new FileSystem(formatFlag, layout);
 #endif // FILESYS_STUB
+    if (genJobs > 0 && !jobList->ProgramsExist())
+	Exit(1);			// rather than time jobs that can't run
     //postOfficeIn = new PostOfficeInput(10);
     //postOfficeOut = new PostOfficeOutput(reliability);
 
-    currentThread = new Thread("main", threadNum++);		
-    currentThread->setStatus(RUNNING);
     interrupt->Enable();
 }
 
@@ -151,30 +233,46 @@ Kernel::Initialize()
 
 Kernel::~Kernel()
 {
+#ifndef FILESYS_STUB
+    fileSystem->Sync();		// while the disk still works
+#endif
     delete stats;
     delete interrupt;
     delete scheduler;
+    for (int i = 0; i < numCpus; i++)
+	delete cpus[i];
     delete alarm;
     delete machine;
     delete synchConsoleIn;
     delete synchConsoleOut;
     delete synchDisk;
     delete fileSystem;
+#ifndef FILESYS_STUB
+    delete openFileTable;
+#endif
     delete postOfficeIn;
     delete postOfficeOut;
+    if (traceBuffer != NULL)
+	delete traceBuffer;		// writes out the rest of the trace
+    delete processTable;
+    if (jobList != NULL)
+	delete jobList;
+    delete execFiles;
+    delete execPriorities;
     
     Exit(0);
 }
 
 //----------------------------------------------------------------------
 // Kernel::ThreadSelfTest
-//      Test threads, semaphores, synchlists
+//      Test threads, semaphores, synchlists, reader-writer locks
 //----------------------------------------------------------------------
 
 void
 Kernel::ThreadSelfTest() {
    Semaphore *semaphore;
    SynchList<int> *synchList;
+   RWLock *rwLock;
    
    LibSelfTest();		// test library routines
    
@@ -191,6 +289,10 @@ Kernel::ThreadSelfTest() {
    synchList->SelfTest(9);
    delete synchList;
 
+   rwLock = new RWLock("test");	// test reader-writer locks
+   rwLock->SelfTest();
+   delete rwLock;
+
 }
 
 //----------------------------------------------------------------------
@@ -207,10 +309,9 @@ Kernel::ConsoleTest() {
         << "Note newlines are needed to flush input through UNIX.\n";
     cout.flush();
 
-    do {
-        ch = synchConsoleIn->GetChar();
-        if(ch != EOF) synchConsoleOut->PutChar(ch);   // echo it!
-    } while (ch != EOF);
+    while (synchConsoleIn->GetChars(&ch, 1) > 0) {	// 0 at end of file
+        synchConsoleOut->PutChar(ch);   // echo it!
+    }
 
     cout << "\n";
 
@@ -287,24 +388,32 @@ void ForkExecute(Thread *t)
 
 void Kernel::ExecAll()
 {
-	for (int i=1;i<=execfileNum;i++) {
-		int a = Exec(execfile[i]);
-	}
+	while (!execFiles->IsEmpty())
+		Exec(execFiles->RemoveFront(), execPriorities->RemoveFront());
 	currentThread->Finish();
     //Kernel::Exec();	
 }
 
 
-int Kernel::Exec(char* name)
+//----------------------------------------------------------------------
+// Kernel::Exec
+// 	Start a thread running the user program "name", and return its
+//	ID.
+//----------------------------------------------------------------------
+
+int Kernel::Exec(char* name, int priority)
 {
-	cout << "Thread " << threadNum << "\t" << name << "\t\t(Pri: " << priority[threadNum] << ")" <<endl;
+	int pid = processTable->NewPid();
+	Thread *t;
+
+	cout << "Thread " << pid << "\t" << name << "\t\t(Pri: " << priority << ")" <<endl;
 	fflush(stdout);
-	t[threadNum] = new Thread(name, threadNum, priority[threadNum]);
-	t[threadNum]->space = new AddrSpace();
-	t[threadNum]->Fork((VoidFunctionPtr) &ForkExecute, (void *)t[threadNum]);
-	threadNum++;
+	t = new Thread(name, pid, priority);
+	processTable->Insert(t);
+	t->space = new AddrSpace();
+	t->Fork((VoidFunctionPtr) &ForkExecute, (void *)t);
 
-	return threadNum-1;
+	return pid;
 /*
     cout << "Total threads number is " << execfileNum << endl;
     for (int n=1;n<=execfileNum;n++) {
@@ -331,6 +440,66 @@ int Kernel::Exec(char* name)
 //    Kernel::Run();
 //  cout << "after ThreadedKernel:Run();" << endl;  // unreachable
 }
+//----------------------------------------------------------------------
+// Kernel::Trace
+// 	A thread has changed state (or queue, priority, or estimated burst
+//	time).  Add the event to the trace, with -trace; otherwise print
+//	it right away.
+//
+//	"kind" -- what happened
+//	"from", "to" -- the thread's state before and after
+//	"queue" -- the ready queue it went to, for TraceQueue
+//	"value" -- its new priority or burst time, for TracePriority and
+//		TraceBurst
+//----------------------------------------------------------------------
+
+void
+Kernel::Trace(TraceKind kind, Thread *thread, ThreadStatus from, 
+		ThreadStatus to, int queue, double value)
+{
+    TraceEvent event;
+
+    event.tick = stats->totalTicks;
+    event.thread = thread->getID();
+    event.value = value;
+    event.kind = kind;
+    event.from = from;
+    event.to = to;
+    event.queue = queue;
+    if (traceBuffer != NULL)
+	traceBuffer->Record(&event);
+    else
+	PrintTraceEvent(&event);
+}
+
+//----------------------------------------------------------------------
+// Kernel::TraceDevice
+// 	A device has done something worth showing on a timeline.  Add
+//	the event to the trace, with -trace; there is no text form.
+//
+//	"kind" -- what happened
+//	"device" -- the interrupt type, for TraceInterrupt; TRUE for a
+//		write, for TraceDiskStart
+//	"value" -- the sector, for TraceDiskStart; the character, for
+//		TraceConsoleRead
+//----------------------------------------------------------------------
+
+void
+Kernel::TraceDevice(TraceKind kind, int device, double value)
+{
+    TraceEvent event;
+
+    if (traceBuffer == NULL)
+	return;
+    event.tick = stats->totalTicks;
+    event.thread = (currentThread != NULL) ? currentThread->getID() : -1;
+    event.value = value;
+    event.kind = kind;
+    event.from = event.to = 0;
+    event.queue = device;
+    traceBuffer->Record(&event);
+}
+
 void Kernel::PrintInt(int number)
 {
 	synchConsoleOut->PutInt(number);	
@@ -18,6 +18,10 @@
 #include "alarm.h"
 #include "filesys.h"
 #include "machine.h"
+#include "cpu.h"
+#include "trace.h"
+#include "proctable.h"
+#include "joblist.h"
 
 class PostOfficeInput;
 class PostOfficeOutput;
@@ -29,10 +33,6 @@ class SynchDisk;
 
 class Kernel {
   public:
-        char jobName[1000][100];
-        int initTime[1000];
-        int listCounter;
-        int totalList;
     Kernel(int argc, char **argv);
     				// Interpret command line arguments
     ~Kernel();		        // deallocate the kernel
@@ -41,17 +41,39 @@ class Kernel {
 				// from constructor because 
 				// refers to "kernel" as a global
 	void ExecAll();
-	int Exec(char* name);
+	int Exec(char* name, int priority = 0);
     void ThreadSelfTest();	// self test of threads and synchronization
 	
     void ConsoleTest();         // interactive console self test
     void NetworkTest();         // interactive 2-machine network test
     void PrintInt(int number);
-	Thread* getThread(int threadID){return t[threadID];}    
+    void Trace(TraceKind kind, Thread *thread, ThreadStatus from, 
+		ThreadStatus to, int queue = 0, double value = 0);
+				// Record a scheduling event, or print 
+				// it if not tracing
+    void TraceDevice(TraceKind kind, int device = 0, double value = 0);
+				// Record a device event, if tracing
+	Thread* getThread(int threadID){return processTable->Lookup(threadID);}
 // These are public for notational convenience; really, 
 // they're global variables used everywhere.
 
     Thread *currentThread;	// the thread holding the CPU
+    int numCpus;		// # of simulated CPUs (-smp)
+    Cpu *cpus[MaxCpus];		// their state
+    Cpu *currentCpu;		// the one being simulated right now
+    bool parallelCpus;		// run them on host threads? (-par)
+    bool fairShare;		// completely fair scheduler? (-cfs)
+    int minGranularity;		// its tunables, in ticks (-gran)
+    int wakeupGranularity;
+    double burstAlpha;		// weight of the last CPU burst in the 
+				// estimated burst time (-alpha)
+    bool srtf;			// preempt for shorter bursts? (-srtf)
+    bool tickless;		// timer only on when there is a time
+				// slice to end? (-tickless)
+    TraceBuffer *traceBuffer;	// binary event trace, or NULL (-trace)
+    ProcessTable *processTable;	// threads, by ID
+    JobList *jobList;		// jobs yet to arrive, or NULL (--test,
+				// -jobs, -gen)
     Scheduler *scheduler;	// the ready list
     Interrupt *interrupt;	// interrupt status
     Statistics *stats;		// performance metrics
@@ -61,6 +83,9 @@ class Kernel {
     SynchConsoleOutput *synchConsoleOut;
     SynchDisk *synchDisk;
     FileSystem *fileSystem;     
+#ifndef FILESYS_STUB
+    OpenFileTable *openFileTable;	// headers of the files now open
+#endif
     PostOfficeInput *postOfficeIn;
     PostOfficeOutput *postOfficeOut;
 
@@ -68,18 +93,23 @@ class Kernel {
 
   private:
 
-	Thread* t[1000];
-	char*   execfile[1000];
-	int priority[1000];
-	int execfileNum;
-	int threadNum;
+    List<char *> *execFiles;	// programs to run (-e, -ep)
+    List<int> *execPriorities;	// and their priorities
     bool randomSlice;		// enable pseudo-random time slicing
     bool debugUserProg;         // single step user program
     double reliability;         // likelihood messages are dropped
     char *consoleIn;            // file to read console input from
     char *consoleOut;           // file to send console output to
+    int consoleBufferSize;	// # of chars the display buffers (-cobuf)
+    char *traceFile;		// file to write the event trace to
+    const char *jobFile;	// file listing the jobs to run (--test,
+				// -jobs)
+    int genSeed;		// synthetic workload to run instead (-gen)
+    int genJobs;
+    int genGap;
 #ifndef FILESYS_STUB
     bool formatFlag;          // format the disk if this is true
+    DiskLayout layout;        // how to lay out a freshly formatted disk
 #endif
 };
 
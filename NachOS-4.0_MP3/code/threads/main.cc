@@ -3,27 +3,53 @@
 //	operating system kernel.  
 //
 // Usage: nachos -d <debugflags> -rs <random seed #>
-//              -s -x <nachos file> -ci <consoleIn> -co <consoleOut>
-//              -f -cp <unix file> <nachos file>
+//              -s -smp <#cpus> -par -cfs -gran <min> <wakeup>
+//              -alpha <weight> -srtf -tickless -trace <trace file>
+//              --test -jobs <job file> -gen <seed> <#jobs> <mean gap>
+//              -x <nachos file> 
+//              -ci <consoleIn> -co <consoleOut> -cobuf <#chars>
+//              -f [-J | -L] -cp <unix file> <nachos file> -P
 //              -p <nachos file> -r <nachos file> -l -D
 //              -n <network reliability> -m <machine id>
-//              -z -K -C -N
+//              -z -K -C -N -B -W
 //
 //    -d causes certain debugging messages to be printed (see debug.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
 //    -z prints the copyright message
 //    -s causes user programs to be executed in single-step mode
+//    -smp simulates a multiprocessor with the given number of CPUs
+//    -par (with -smp) runs the simulated CPUs on host threads
+//    -cfs schedules threads by virtual runtime (completely fair)
+//    -gran (with -cfs) sets the minimum and wakeup granularities, in ticks
+//    -alpha sets the weight of the last CPU burst in the SJF estimate
+//    -srtf lets a shorter SJF job preempt the running one
+//    -tickless only runs the timer when a time slice may need ending
+//    -trace records scheduling and device events in a binary file, 
+//	instead of printing them (use tracecat to print the file, or
+//	"tracecat -chrome" to view it in the Chrome trace viewer)
+//    --test runs the jobs listed in the file "JobList", as they arrive
+//    -jobs does the same for any job file (cf. threads/joblist.h)
+//    -gen runs a synthetic workload of CPU- and I/O-bound jobs, arriving
+//	<mean gap> ticks apart on average
 //    -x runs a user program
 //    -ci specify file for console input (stdin is the default)
 //    -co specify file for console output (stdout is the default)
+//    -cobuf sets how many characters the console display buffers, to
+//	send out in one burst (1 is the default)
 //    -n sets the network reliability
 //    -m sets this machine's host id (needed for the network)
 //    -K run a simple self test of kernel threads and synchronization
 //    -C run an interactive console test
 //    -N run a two-machine network test (see Kernel::NetworkTest)
+//    -B time SortedList against SkipList (see LibBenchmark)
+//    -W time Lock against RWLock, with and without -smp (see 
+//	LockBenchmark)
 //
 //    Filesystem-related flags:
 //    -f forces the Nachos disk to be formatted
+//    -J (with -f) formats the disk with a log for metadata updates
+//    -L (with -f) formats the disk with a log-structured layout
+//    -P runs a file system performance test (to compare layouts)
 //    -cp copies a file from UNIX to Nachos
 //    -p prints a Nachos file to stdout
 //    -r removes a Nachos file from the file system
@@ -45,6 +71,8 @@
 #include "filesys.h"
 #include "openfile.h"
 #include "sysdep.h"
+#include "libtest.h"
+#include "synch.h"
 
 // global variables
 Kernel *kernel;
@@ -118,6 +146,72 @@ Copy(char *from, char *to)
     Close(fd);
 }
 
+//----------------------------------------------------------------------
+// PerformanceTest
+//      Stress the file system: create a few files, fill them a chunk
+//	at a time in round-robin order (so that the writes are scattered
+//	over the disk), then read each one back sequentially.  Print how
+//	long each phase took, so that disk layouts can be compared.
+//----------------------------------------------------------------------
+
+static const int PerfNumFiles = 4;
+static const int PerfFileSize = 3 * 1024;
+
+static void
+PerformanceTest()
+{
+    char name[] = "perf0";
+    OpenFile *files[PerfNumFiles];
+    char *buffer = new char[TransferSize];
+    int startTicks, startReads, startWrites;
+    Statistics *stats = kernel->stats;
+
+    printf("Starting file system performance test:\n");
+    for (int i = 0; i < PerfNumFiles; i++) {
+	name[4] = '0' + i;
+	if (!kernel->fileSystem->Create(name, PerfFileSize)) {
+	    printf("Perf test: can't create %s\n", name);
+	    delete [] buffer;
+	    return;
+	}
+	files[i] = kernel->fileSystem->Open(name);
+    }
+
+    for (int i = 0; i < TransferSize; i++)
+	buffer[i] = 'a' + (i % 26);
+    startTicks = stats->totalTicks;
+    startReads = stats->numDiskReads;
+    startWrites = stats->numDiskWrites;
+    for (int done = 0; done < PerfFileSize; done += TransferSize)
+	for (int i = 0; i < PerfNumFiles; i++)
+	    files[i]->Write(buffer, TransferSize);
+    kernel->fileSystem->Sync();
+    printf("Write: %d bytes, %d ticks, %d disk reads, %d disk writes\n",
+		PerfNumFiles * PerfFileSize, stats->totalTicks - startTicks,
+		stats->numDiskReads - startReads,
+		stats->numDiskWrites - startWrites);
+
+    startTicks = stats->totalTicks;
+    startReads = stats->numDiskReads;
+    startWrites = stats->numDiskWrites;
+    for (int i = 0; i < PerfNumFiles; i++) {
+	files[i]->Seek(0);
+	while (files[i]->Read(buffer, TransferSize) > 0)
+	    ;
+    }
+    printf("Read: %d bytes, %d ticks, %d disk reads, %d disk writes\n",
+		PerfNumFiles * PerfFileSize, stats->totalTicks - startTicks,
+		stats->numDiskReads - startReads,
+		stats->numDiskWrites - startWrites);
+
+    for (int i = 0; i < PerfNumFiles; i++) {
+	delete files[i];
+	name[4] = '0' + i;
+	kernel->fileSystem->Remove(name);
+    }
+    delete [] buffer;
+}
+
 #endif // FILESYS_STUB
 
 //----------------------------------------------------------------------
@@ -172,6 +266,8 @@ main(int argc, char **argv)
     bool threadTestFlag = false;
     bool consoleTestFlag = false;
     bool networkTestFlag = false;
+    bool benchmarkFlag = false;
+    bool lockBenchmarkFlag = false;
 #ifndef FILESYS_STUB
     char *copyUnixFileName = NULL;    // UNIX file to be copied into Nachos
     char *copyNachosFileName = NULL;  // name of copied file in Nachos
@@ -179,6 +275,7 @@ main(int argc, char **argv)
     char *removeFileName = NULL;
     bool dirListFlag = false;
     bool dumpFlag = false;
+    bool perfTestFlag = false;
 #endif //FILESYS_STUB
 
     // some command line arguments are handled here.
@@ -207,6 +304,12 @@ main(int argc, char **argv)
 	else if (strcmp(argv[i], "-N") == 0) {
 	    networkTestFlag = TRUE;
 	}
+	else if (strcmp(argv[i], "-B") == 0) {
+	    benchmarkFlag = TRUE;
+	}
+	else if (strcmp(argv[i], "-W") == 0) {
+	    lockBenchmarkFlag = TRUE;
+	}
 #ifndef FILESYS_STUB
 	else if (strcmp(argv[i], "-cp") == 0) {
 	    ASSERT(i + 2 < argc);
@@ -230,15 +333,18 @@ main(int argc, char **argv)
 	else if (strcmp(argv[i], "-D") == 0) {
 	    dumpFlag = true;
 	}
+	else if (strcmp(argv[i], "-P") == 0) {
+	    perfTestFlag = true;
+	}
 #endif //FILESYS_STUB
 	else if (strcmp(argv[i], "-u") == 0) {
             cout << "Partial usage: nachos [-z -d debugFlags]\n";
             cout << "Partial usage: nachos [-x programName]\n";
-	    cout << "Partial usage: nachos [-K] [-C] [-N]\n";
+	    cout << "Partial usage: nachos [-K] [-C] [-N] [-B] [-W]\n";
 #ifndef FILESYS_STUB
             cout << "Partial usage: nachos [-cp UnixFile NachosFile]\n";
             cout << "Partial usage: nachos [-p fileName] [-r fileName]\n";
-            cout << "Partial usage: nachos [-l] [-D]\n";
+            cout << "Partial usage: nachos [-l] [-D] [-P]\n";
 #endif //FILESYS_STUB
 	}
 
@@ -264,6 +370,12 @@ main(int argc, char **argv)
     if (networkTestFlag) {
       kernel->NetworkTest();   // two-machine test of the network
     }
+    if (benchmarkFlag) {
+      LibBenchmark();		// time the sorted list implementations
+    }
+    if (lockBenchmarkFlag) {
+      LockBenchmark();		// time readers and writers under contention
+    }
 
 #ifndef FILESYS_STUB
     if (removeFileName != NULL) {
@@ -281,6 +393,9 @@ main(int argc, char **argv)
     if (printFileName != NULL) {
       Print(printFileName);
     }
+    if (perfTestFlag) {
+      PerformanceTest();
+    }
 #endif // FILESYS_STUB
 
     // finally, run an initial user program if requested to do so
@@ -0,0 +1,110 @@
+// proctable.cc
+//	Routines to manage the process table, which maps thread IDs to
+//	threads.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "proctable.h"
+#include "thread.h"
+
+//----------------------------------------------------------------------
+// ProcessTable::ProcessTable
+// 	Initialize an empty process table.
+//----------------------------------------------------------------------
+
+ProcessTable::ProcessTable()
+{
+    size = InitialPids;
+    table = new Thread *[size];
+    for (int i = 0; i < size; i++)
+	table[i] = NULL;
+    nextPid = 0;
+    numThreads = 0;
+    reuse = 0;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::~ProcessTable
+// 	De-allocate the table (but not the threads in it).
+//----------------------------------------------------------------------
+
+ProcessTable::~ProcessTable()
+{
+    delete [] table;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Grow
+// 	Double the size of the table.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Grow()
+{
+    Thread **old = table;
+
+    table = new Thread *[size * 2];
+    for (int i = 0; i < size; i++)
+	table[i] = old[i];
+    for (int i = size; i < size * 2; i++)
+	table[i] = NULL;
+    size *= 2;
+    delete [] old;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::NewPid
+// 	Return an ID that no thread in the table has.  Until MaxPid IDs
+//	have been used, this is the next one in order; after that, it is
+//	the next free one, going round the used IDs, unless they are all
+//	taken.
+//----------------------------------------------------------------------
+
+int
+ProcessTable::NewPid()
+{
+    if (nextPid >= MaxPid && numThreads < nextPid) {
+	while (table[reuse] != NULL)
+	    reuse = (reuse + 1) % nextPid;
+	return reuse;
+    }
+    if (nextPid == size)
+	Grow();
+    return nextPid++;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Insert
+// 	Add "thread" to the table, under its ID (from NewPid).
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Insert(Thread *thread)
+{
+    int pid = thread->getID();
+
+    ASSERT(pid >= 0 && pid < nextPid && table[pid] == NULL);
+    table[pid] = thread;
+    numThreads++;
+}
+
+//----------------------------------------------------------------------
+// ProcessTable::Remove
+// 	Take "thread" out of the table, if it is there, so that its ID
+//	can be reused.  Threads made with an ID of their own choosing
+//	(by the self tests) are not in the table.
+//----------------------------------------------------------------------
+
+void
+ProcessTable::Remove(Thread *thread)
+{
+    int pid = thread->getID();
+
+    if (Lookup(pid) == thread) {
+	table[pid] = NULL;
+	numThreads--;
+    }
+}
@@ -0,0 +1,54 @@
+// proctable.h
+//	Data structures for finding a thread by its ID.
+//
+//	The process table maps thread IDs to threads.  IDs are handed out
+//	in order, as before, so a run that makes few threads numbers them
+//	0 (main), 1, 2, ...  Once MaxPid IDs have been used, the table
+//	wraps around, as UNIX does, and hands out the IDs of threads that
+//	have since been deleted.  The table grows as needed, so there is
+//	no fixed limit on the number of threads alive at once.
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROCTABLE_H
+#define PROCTABLE_H
+
+#include "copyright.h"
+#include "debug.h"
+
+#define MaxPid		32768		// start reusing IDs after this many
+#define InitialPids	64		// initial size of the table
+
+class Thread;
+
+// The following class defines the process table.
+
+class ProcessTable {
+  public:
+    ProcessTable();			// initialize an empty table
+    ~ProcessTable();			// de-allocate the table
+
+    int NewPid();			// pick an ID for a new thread;
+					// Insert the thread before asking
+					// for another one
+    void Insert(Thread *thread);	// add a thread, under its ID
+    void Remove(Thread *thread);	// take a thread out, freeing its ID
+
+    Thread *Lookup(int pid) {		// the thread with ID "pid", or NULL
+	return (pid >= 0 && pid < nextPid) ? table[pid] : NULL;
+    }
+
+  private:
+    Thread **table;			// the threads, indexed by ID
+    int size;				// # of entries in "table"
+    int nextPid;			// IDs below this have been used
+    int numThreads;			// # of threads in the table
+    int reuse;				// where to look for a free ID,
+					// once we have wrapped around
+
+    void Grow();			// double the size of the table
+};
+
+#endif // PROCTABLE_H
@@ -4,15 +4,17 @@
 //
 // 	These routines assume that interrupts are already disabled.
 //	If interrupts are disabled, we can assume mutual exclusion
-//	(since we are on a uniprocessor).
+//	(since we are on a uniprocessor -- even when simulating several
+//	CPUs, we only switch between them as interrupts are re-enabled).
 //
 // 	NOTE: We can't use Locks to provide mutual exclusion here, since
 // 	if we needed to wait for a lock, and the lock was busy, we would 
 //	end up calling FindNextToRun(), and that would put us in an 
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	Three bands of ready threads -- SJF, round robin and priority --
+//	per simulated CPU, or with -cfs, a queue ordered by virtual 
+//	runtime; cf. scheduler.h.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -31,10 +33,19 @@
 
 Scheduler::Scheduler()
 { 
-    readyList = new SortedList< Thread *>(Thread::compare_by_priority); // OAO
-    readyRRList = new List< Thread *>(); // OAO work item 2(1)
-    readySJFList = new SortedList< Thread *>(Thread::compare_by_burst);// OAO 2-2
+    for (int i = 0; i < MaxCpus; i++) {
+	if (i >= kernel->numCpus)
+	    queues[i] = NULL;
+	else if (kernel->fairShare)
+	    queues[i] = new FairQueue();
+	else
+	    queues[i] = new BandQueue();
+    }
     toBeDestroyed = NULL;
+    numFinished = 0;
+    totalTurnaround = totalWaiting = 0;
+    maxTurnarounds = 64;
+    turnarounds = new int[maxTurnarounds];
 } 
 
 //----------------------------------------------------------------------
@@ -44,9 +55,9 @@ Scheduler::Scheduler()
 
 Scheduler::~Scheduler()
 { 
-    delete readyList; 
-    delete readyRRList;
-    delete readySJFList;
+    for (int i = 0; i < MaxCpus; i++)
+	delete queues[i];
+    delete [] turnarounds;
 }
 
 //----------------------------------------------------------------------
@@ -54,45 +65,68 @@ Scheduler::~Scheduler()
 // 	Mark a thread as ready, but not running.
 //	Put it on the ready list, for later scheduling onto the CPU.
 //
+//	A thread that has just woken up, or is new, may preempt a 
+//	running thread.
+//
 //	"thread" is the thread to be put on the ready list.
 //----------------------------------------------------------------------
 
 void
 Scheduler::ReadyToRun (Thread *thread)
 {
+    ThreadStatus from = thread->getStatus();
+    bool waking = (from == BLOCKED);
+    bool arriving = waking || (from == JUST_CREATED);
+    int cpu;
+
     ASSERT(kernel->interrupt->getLevel() == IntOff);
     DEBUG(dbgThread, "Putting thread on ready list: " << thread->getName());
-	//cout << "Putting thread on ready list: " << thread->getName() << endl ;
+    if (from == RUNNING)		// yielding
+	Charge(thread);
     thread->setStatus(READY);
     thread->setReadyTime(kernel->stats->totalTicks);//OAO work item 1(3)
-    // here?
-    // aging(readyList);//OAO work item 1(3)
-    // aging(readyRRList);// OAO work item 2(1)
-    // aging(readySJFList);// OAO ?
-    cout << "Thread " <<  thread->getID() << "\tProcessReady\t" << kernel->stats->totalTicks << endl;
-    // 0 ~ 59 : priority queue
-    if(thread->getPriority()<60){// OAO priority queue
-        cout<<"Tick "<<kernel->stats->totalTicks<<" Thread "<<thread->getID()<<" move to Priority queue"<<endl;
-        readyList->Insert(thread);// OAO Append is private
-    }
-    // 60 ~ 99 : RR queue
-    else if(60 <= thread->getPriority() && thread->getPriority() < 100){ // OAO RR queue
-        cout<<"Tick "<<kernel->stats->totalTicks<<" Thread "<<thread->getID()<<" move to RR queue"<<endl;
-        readyRRList->Append(thread);
-    }
-    // 100 ~ 149 : SJF queue
-    else{
-        cout<<"Tick "<<kernel->stats->totalTicks<<" Thread "<<thread->getID()<<" move to SJF queue"<<endl;
-        readySJFList->Insert(thread);
+    thread->setWaitStart(kernel->stats->totalTicks);
+    kernel->Trace(TraceReady, thread, from, READY);
+    cpu = QueueFor(thread);
+    queues[cpu]->Insert(thread, waking);
+    if (kernel->tickless && !SlicesByClock())
+	kernel->alarm->Resume();	// there's a time slice to end
+    if (arriving)
+	CheckPreempt(cpu, thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::CheckPreempt
+// 	"thread" has just woken up (or been created), and been put on the
+//	queue of CPU "cpu".  If it should take over from the thread running there,
+//	end that thread's time slice: the CPU yields on its next tick 
+//	(cf. Interrupt::OneTick).
+//----------------------------------------------------------------------
+
+void
+Scheduler::CheckPreempt(int cpu, Thread *thread)
+{
+    Cpu *c = kernel->cpus[cpu];
+    Thread *running = (c == kernel->currentCpu) ? kernel->currentThread 
+						: c->running;
+
+    if (running == NULL || running->getStatus() != RUNNING)
+	return;
+    Charge(running);
+    if (queues[cpu]->Preempts(thread, running)) {
+	DEBUG(dbgThread, "Thread " << thread->getName() << " preempts " 
+			<< running->getName());
+	c->sliceEnd = 0;
     }
-    // aging(readyList);//OAO work item 1(3)
-    
 }
 
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
-// 	Return the next thread to be scheduled onto the CPU.
+// 	Return the next thread to be scheduled onto the current CPU.
 //	If there are no ready threads, return NULL.
+//
+//	Take it from the CPU's own queue if we can, otherwise steal one
+//	from the busiest queue.
 // Side effect:
 //	Thread is removed from the ready list.
 //----------------------------------------------------------------------
@@ -100,26 +134,86 @@ Scheduler::ReadyToRun (Thread *thread)
 Thread *
 Scheduler::FindNextToRun ()
 {
+    int cpu = kernel->currentCpu->id;
+    Thread *thread;
+
     ASSERT(kernel->interrupt->getLevel() == IntOff);
-    aging(readyList);//OAO work item 1(3)
-    // aging(readyRRList);// OAO work item 2(1)
-    // aging(readySJFList);// OAO because the sorted index is burst but aging changes the priority, this implementation will be aborted while running
-    if(readySJFList->IsEmpty()){// 2-2
-        if(readyRRList->IsEmpty()){// work item 2(1)
-            if (readyList->IsEmpty()) {
-                return NULL;
-            } else {
-                return readyList->RemoveFront();
-            }    
-        }
-        else{
-            return readyRRList->RemoveFront();
-        }    
-    }
-    else{
-        return readySJFList->RemoveFront();
+    queues[cpu]->Update();//OAO work item 1(3)
+    thread = queues[cpu]->RemoveFront();
+    if (thread == NULL && kernel->numCpus > 1)
+	thread = Steal(cpu);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::QueueFor
+// 	Return the CPU whose queue a ready thread should go on: the one
+//	it last ran on, to keep its cache warm.  A thread that has never
+//	run goes to the CPU with the least to do.
+//----------------------------------------------------------------------
+
+static int
+CpuLoad(int cpu, ReadyQueue *queue)
+{
+    Cpu *c = kernel->cpus[cpu];
+    bool busy = (c == kernel->currentCpu) || (c->running != NULL);
+
+    return queue->NumReady() + (busy ? 1 : 0);
+}
+
+int
+Scheduler::QueueFor(Thread *thread)
+{
+    int cpu = thread->getCpu();
+
+    if (cpu == -1) {
+	cpu = 0;
+	for (int i = 1; i < kernel->numCpus; i++)
+	    if (CpuLoad(i, queues[i]) < CpuLoad(cpu, queues[cpu]))
+		cpu = i;
     }
-    
+    return cpu;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Steal
+// 	The queue of CPU "cpu" is empty.  Take the next thread to run from
+//	the queue with the most threads, and return it; NULL if all the
+//	queues are empty.  The thread now belongs to "cpu".
+//----------------------------------------------------------------------
+
+Thread *
+Scheduler::Steal(int cpu)
+{
+    int victim = -1;
+    Thread *thread;
+
+    for (int i = 0; i < kernel->numCpus; i++)
+	if (i != cpu && queues[i]->NumReady() > 0
+		&& (victim == -1 || queues[i]->NumReady() > queues[victim]->NumReady()))
+	    victim = i;
+    if (victim == -1)
+	return NULL;
+    queues[victim]->Update();
+    thread = queues[victim]->RemoveFront();
+    DEBUG(dbgThread, "CPU " << cpu << " steals " << thread->getName() 
+			<< " from CPU " << victim);
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::NumReady
+// 	Return the number of threads waiting to run, on all the CPUs.
+//----------------------------------------------------------------------
+
+int
+Scheduler::NumReady()
+{
+    int n = 0;
+
+    for (int i = 0; i < kernel->numCpus; i++)
+	n += queues[i]->NumReady();
+    return n;
 }
 
 //----------------------------------------------------------------------
@@ -143,16 +237,53 @@ void
 Scheduler::Run (Thread *nextThread, bool finishing)
 {
     Thread *oldThread = kernel->currentThread;
+    Cpu *cpu = kernel->currentCpu;
     
     ASSERT(kernel->interrupt->getLevel() == IntOff);
 
-    //OAO old thread == new thread => don't do context switch(?)
-    // if(oldThread->getID()==nextThread->getID())return;
     if (finishing) {	// mark that we need to delete current thread
          ASSERT(toBeDestroyed == NULL);
 	 toBeDestroyed = oldThread;
     }
     
+    Dispatch(nextThread, cpu);	// nextThread is now running
+    
+    DEBUG(dbgThread, "Switching from: " << oldThread->getName() << " to: " << nextThread->getName());
+    
+    Switch(oldThread, nextThread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Dispatch
+// 	Mark "thread", just taken off a ready queue, as running on "cpu",
+//	and start its time slice.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Dispatch(Thread *thread, Cpu *cpu)
+{
+    int now = kernel->stats->totalTicks;
+
+    kernel->Trace(TraceRunning, thread, thread->getStatus(), RUNNING);
+    thread->setStatus(RUNNING);
+    thread->setCpu(cpu->id);
+    thread->setRunStart(now);
+    thread->setStartBurstTime(now);// OAO 2-2
+    thread->addWaitTicks(now - thread->getWaitStart());
+    cpu->sliceEnd = max(cpu->clock, now) 
+			+ queues[cpu->id]->TimeSlice(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Switch
+// 	Save the state of the old thread, and load the state of the new
+//	thread, by calling the machine dependent context switch routine,
+//	SWITCH.  Returns when the old thread runs again.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Switch(Thread *oldThread, Thread *nextThread)
+{
     if (oldThread->space != NULL) {	// if this thread is a user program,
         oldThread->SaveUserState(); 	// save the user's CPU registers
 	oldThread->space->SaveState();
@@ -162,23 +293,12 @@ Scheduler::Run (Thread *nextThread, bool finishing)
 					    // had an undetected stack overflow
     
     kernel->currentThread = nextThread;  // switch to the next thread
-    nextThread->setStatus(RUNNING);      // nextThread is now running
-    cout << "Thread " << kernel->currentThread->getID() << "\tProcessRunning\t" << kernel->stats->totalTicks << endl;
-    
-    DEBUG(dbgThread, "Switching from: " << oldThread->getName() << " to: " << nextThread->getName());
-    
+
     // This is a machine-dependent assembly language routine defined 
     // in switch.s.  You may have to think
     // a bit to figure out what happens after this, both from the point
     // of view of the thread and from the perspective of the "outside world".
 
-
-    // OAO 2-2?
-    // because I don't want to print the information of Thread 0?
-    // if(oldThread->getID())
-        oldThread->setBurstTime( (kernel->stats->totalTicks - oldThread->getStartBurstTime() + oldThread->getBurstTime()) / 2.0 );//OAO 2-2?
-    nextThread->setStartBurstTime(kernel->stats->totalTicks);// OAO 2-2
-    
     SWITCH(oldThread, nextThread);
 
     // we're back, running oldThread
@@ -198,6 +318,297 @@ Scheduler::Run (Thread *nextThread, bool finishing)
     }
 }
 
+//----------------------------------------------------------------------
+// Scheduler::NextCpu
+// 	With several simulated CPUs, called after every tick.  Switch to
+//	the CPU whose clock is furthest behind -- among the busy ones, and
+//	the idle ones that could find a thread to run -- if it is behind
+//	the current CPU.  The current thread stays running on its CPU,
+//	and picks up where it left off when its CPU's turn comes.
+//----------------------------------------------------------------------
+
+void
+Scheduler::NextCpu()
+{
+    Cpu *current = kernel->currentCpu, *to = NULL, *cpu;
+    Thread *nextThread;
+    int clock, toClock = 0, numReady = 0;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    for (int i = 0; i < kernel->numCpus; i++)
+	numReady += queues[i]->NumReady();
+    for (int i = 0; i < kernel->numCpus; i++) {
+	cpu = kernel->cpus[i];
+	if (cpu == current)
+	    continue;
+	if (cpu->running != NULL)
+	    clock = cpu->clock;
+	else if (numReady > 0)		// idle, but there is work
+	    clock = max(cpu->clock, kernel->stats->totalTicks);
+	else
+	    continue;
+	if (clock < current->clock && (to == NULL || clock < toClock)) {
+	    to = cpu;
+	    toClock = clock;
+	}
+    }
+    if (to == NULL)
+	return;
+
+    if (to->running != NULL) {
+	nextThread = to->running;
+	to->running = NULL;
+    } else {
+	kernel->currentCpu = to;	// so we look at to's queue first
+	nextThread = FindNextToRun();
+	kernel->currentCpu = current;
+	ASSERT(nextThread != NULL);
+    }
+    current->running = kernel->currentThread;
+    SwitchCpu(to, nextThread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::IdleCpu
+// 	The current thread is going to sleep, and there is nothing else
+//	for its CPU to do.  If another CPU is busy, leave this one idle
+//	and switch to that one; return TRUE once the current thread has
+//	been woken up and run again (unless it is finishing).
+//
+//	Return FALSE if every other CPU is idle too, so the caller has
+//	to wait for an interrupt.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::IdleCpu(bool finishing)
+{
+    Cpu *to = NULL, *cpu;
+    Thread *nextThread;
+
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    for (int i = 0; i < kernel->numCpus; i++) {
+	cpu = kernel->cpus[i];
+	if (cpu->running != NULL && (to == NULL || cpu->clock < to->clock))
+	    to = cpu;
+    }
+    if (to == NULL)
+	return FALSE;
+
+    if (finishing) {
+	ASSERT(toBeDestroyed == NULL);
+	toBeDestroyed = kernel->currentThread;
+    }
+    nextThread = to->running;
+    to->running = NULL;
+    SwitchCpu(to, nextThread);
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SwitchCpu
+// 	Make "to" the CPU being simulated, running "nextThread" -- either
+//	the thread that was parked on it, or, if it was idle, a thread
+//	just taken from a ready queue.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SwitchCpu(Cpu *to, Thread *nextThread)
+{
+    if (nextThread->getStatus() != RUNNING) {	// "to" was idle
+	to->clock = max(to->clock, kernel->stats->totalTicks);
+	Dispatch(nextThread, to);
+    }
+    DEBUG(dbgThread, "Switching from CPU " << kernel->currentCpu->id 
+			<< " to CPU " << to->id);
+    kernel->currentCpu = to;
+    Switch(kernel->currentThread, nextThread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::CpuTime
+// 	Return the clock of the busy CPU that is furthest behind: how far
+//	simulated time has got.  The current CPU is always busy.
+//----------------------------------------------------------------------
+
+int
+Scheduler::CpuTime()
+{
+    int time = kernel->currentCpu->clock;
+
+    for (int i = 0; i < kernel->numCpus; i++)
+	if (kernel->cpus[i]->running != NULL)
+	    time = min(time, kernel->cpus[i]->clock);
+    return time;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::TimeSlice
+// 	Return how long "thread" may run on the current CPU before it
+//	is preempted.
+//----------------------------------------------------------------------
+
+int
+Scheduler::TimeSlice(Thread *thread)
+{
+    return queues[kernel->currentCpu->id]->TimeSlice(thread);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Charge
+// 	Add the CPU time "thread" has had since it was last charged (or
+//	started running) to its current burst, and to its virtual 
+//	runtime, weighted by its priority.  Called whenever a running 
+//	thread stops, and before its CPU time is looked at.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Charge(Thread *thread)
+{
+    int now = kernel->stats->totalTicks;
+    int ran = now - thread->getRunStart();
+
+    thread->setBurstSoFar(thread->getBurstSoFar() + ran);
+    thread->setVruntime(thread->getVruntime() + (double) ran 
+			* NiceZeroWeight / FairWeight(thread->getPriority()));
+    thread->setRunStart(now);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::EndBurst
+// 	"thread" is blocking, so its CPU burst is over.  Fold the burst
+//	into the thread's estimated burst time, an exponentially weighted
+//	average: the new burst counts for "alpha" (-alpha), the old 
+//	estimate for the rest.
+//
+//	A thread that is preempted, or yields, is still in the same 
+//	burst when it runs again.
+//----------------------------------------------------------------------
+
+void
+Scheduler::EndBurst(Thread *thread)
+{
+    double alpha = kernel->burstAlpha;
+
+    thread->setBurstTime(alpha * thread->getBurstSoFar() 
+				+ (1 - alpha) * thread->getBurstTime());
+    thread->setBurstSoFar(0);
+}
+
+//----------------------------------------------------------------------
+// RemainingBurst
+// 	Return how much longer "thread" is expected to run before it 
+//	blocks: its estimated burst time, less what it has had of its
+//	current burst.
+//----------------------------------------------------------------------
+
+static double
+RemainingBurst(Thread *thread)
+{
+    return max(0.0, thread->getBurstTime() - thread->getBurstSoFar());
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SlicesByClock
+// 	Return TRUE if time slices end (and preemptions happen) at a 
+//	given time on the CPU's clock, checked on every tick -- rather 
+//	than at the next timer interrupt.
+//----------------------------------------------------------------------
+
+bool
+Scheduler::SlicesByClock()
+{
+    return kernel->numCpus > 1 || kernel->fairShare || kernel->srtf;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Finished
+// 	"thread" is finishing; add its turnaround time (since it was 
+//	created) and waiting time (spent ready, but not running) to the
+//	totals.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Finished(Thread *thread)
+{
+    int turnaround = kernel->stats->totalTicks - thread->getArrivalTime();
+    int *old;
+
+    if (numFinished == maxTurnarounds) {	// double the array
+	old = turnarounds;
+	turnarounds = new int[maxTurnarounds * 2];
+	for (int i = 0; i < numFinished; i++)
+	    turnarounds[i] = old[i];
+	maxTurnarounds *= 2;
+	delete [] old;
+    }
+    turnarounds[numFinished++] = turnaround;
+    totalTurnaround += turnaround;
+    totalWaiting += thread->getWaitTicks();
+}
+
+//----------------------------------------------------------------------
+// CompareTicks
+// 	Compare two times, for qsort.
+//----------------------------------------------------------------------
+
+static int
+CompareTicks(const void *x, const void *y)
+{
+    return *(const int *) x - *(const int *) y;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Percentile
+// 	Return the "p"th percentile (nearest rank) of the turnaround
+//	times, once they are sorted.
+//----------------------------------------------------------------------
+
+int
+Scheduler::Percentile(int p)
+{
+    int rank = divRoundUp(p * numFinished, 100);
+
+    return turnarounds[max(rank, 1) - 1];
+}
+
+//----------------------------------------------------------------------
+// Scheduler::PrintStats
+// 	Print the average turnaround and waiting times of the threads
+//	that have finished, and the policy they were scheduled with.
+//	Then, to compare policies under load, the throughput, the spread
+//	of turnaround times, and how busy the CPUs were.
+//----------------------------------------------------------------------
+
+void
+Scheduler::PrintStats()
+{
+    Statistics *stats = kernel->stats;
+
+    cout << "Scheduling: ";
+    if (kernel->fairShare)
+	cout << "CFS";
+    else if (kernel->srtf)
+	cout << "bands, SRTF";
+    else
+	cout << "bands";
+    cout << ", threads finished " << numFinished;
+    if (numFinished > 0)
+	cout << ", average turnaround " << totalTurnaround / numFinished
+		<< ", average waiting " << totalWaiting / numFinished;
+    cout << "\n";
+    if (numFinished == 0 || stats->totalTicks == 0)
+	return;
+    qsort(turnarounds, numFinished, sizeof(int), CompareTicks);
+    cout << "Workload: throughput " 
+	<< numFinished * 1000.0 / stats->totalTicks << " per 1000 ticks"
+	<< ", turnaround p50 " << Percentile(50) << ", p90 " << Percentile(90)
+	<< ", p99 " << Percentile(99) << ", max " << Percentile(100)
+	<< ", CPU utilization " 
+	<< 100.0 * (stats->systemTicks + stats->userTicks) 
+				/ (kernel->numCpus * stats->totalTicks) 
+	<< "%\n";
+}
+
 //----------------------------------------------------------------------
 // Scheduler::CheckToBeDestroyed
 // 	If the old thread gave up the processor because it was finishing,
@@ -224,67 +635,586 @@ void
 Scheduler::Print()
 {
     cout << "Ready list contents:\n";
-    readyList->Apply(ThreadPrint);
+    for (int i = 0; i < kernel->numCpus; i++) {
+	if (kernel->numCpus > 1)
+	    cout << "CPU " << i << ":\n";
+	queues[i]->Print();
+    }
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::TimeSlice
+// 	Return how long "thread" may run: by default, until the next 
+//	timer interrupt.
+//----------------------------------------------------------------------
+
+int
+ReadyQueue::TimeSlice(Thread *thread)
+{
+    return TimerTicks;
+}
+
+//----------------------------------------------------------------------
+// ReadyQueue::Preempts
+// 	Return TRUE if "thread", just woken up, should take over from 
+//	"running" right away.  By default, never.
+//----------------------------------------------------------------------
+
+bool
+ReadyQueue::Preempts(Thread *thread, Thread *running)
+{
+    return FALSE;
+}
+
+//----------------------------------------------------------------------
+// BandQueue::Preempts
+// 	With -srtf, a thread arriving in the SJF band preempts a running
+//	SJF thread that is expected to take longer to finish its burst.
+//	"running" has just been charged for the time it has run.
+//----------------------------------------------------------------------
+
+bool
+BandQueue::Preempts(Thread *thread, Thread *running)
+{
+    if (!kernel->srtf || thread->getPriority() < 100 
+				|| running->getPriority() < 100)
+	return FALSE;
+    return RemainingBurst(thread) < RemainingBurst(running);
+}
+
+//----------------------------------------------------------------------
+// BandQueue::BandQueue
+// 	Initialize an empty ready queue.
+//----------------------------------------------------------------------
+
+BandQueue::BandQueue()
+{
+    for (int i = 0; i < NumPriorityLevels; i++)
+	readyList[i] = new IntrusiveList<Thread>();
+    for (int i = 0; i < PriorityMapWords; i++)
+	priorityMap[i] = 0;
+    nextAging = 0;
+    readyRRList = new IntrusiveList<Thread>(); // OAO work item 2(1)
+    readySJFList = new BurstHeap();	// OAO 2-2
+    numReady = 0;
+}
+
+//----------------------------------------------------------------------
+// BandQueue::~BandQueue
+// 	De-allocate the ready queue.
+//----------------------------------------------------------------------
+
+BandQueue::~BandQueue()
+{
+    for (int i = 0; i < NumPriorityLevels; i++)
+	delete readyList[i]; 
+    delete readyRRList;
+    delete readySJFList;
+}
+
+//----------------------------------------------------------------------
+// BandQueue::RemoveFront
+// 	Remove the next thread to run from the queue, and return it.
+//	If there are no ready threads, return NULL.
+//
+//	Each band is a FIFO, or a set of FIFOs indexed by a bitmap of
+//	the levels that have a thread, so this takes the same time however
+//	many threads are ready -- except in the SJF band, which is a heap.
+//----------------------------------------------------------------------
+
+Thread *
+BandQueue::RemoveFront()
+{
+    int level;
+    Thread *thread;
+
+    if (!readySJFList->IsEmpty())	// 2-2
+	thread = readySJFList->RemoveFront();
+    else if (!readyRRList->IsEmpty())	// work item 2(1)
+	thread = readyRRList->RemoveFront();
+    else {
+	level = HighestLevel();
+	if (level == -1)
+	    return NULL;
+	thread = readyList[level]->RemoveFront();
+	if (readyList[level]->IsEmpty())
+	    ClearLevel(level);
+    }
+    numReady--;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// BandQueue::Print
+// 	Print the threads in the queue, in the order they would run
+//	(except within the SJF band).
+//----------------------------------------------------------------------
+
+void
+BandQueue::Print()
+{
+    readySJFList->Apply(ThreadPrint);
+    readyRRList->Apply(ThreadPrint);
+    for (int level = NumPriorityLevels - 1; level >= 0; level--)
+	readyList[level]->Apply(ThreadPrint);
 }
 
+//----------------------------------------------------------------------
+// BandQueue::aging
+// 	Raise by AgingStep the priority of every thread in the priority
+//	band that has been waiting for AgingInterval ticks or more, and
+//	move it to its new queue.
+//
+//	Threads are appended to a level with their ready time set to now,
+//	so each level is in order of ready time: we only need to look at
+//	the front of the levels that have a thread.  Levels are visited
+//	from the highest down, and an aged thread only moves up, to a
+//	level already visited.
+//
+//	While looking, we note when the next thread will be due, and
+//	until then a dispatch doesn't look at all.
+//----------------------------------------------------------------------
+
 void
-Scheduler::aging(SortedList<Thread*>* list)// OAO
-{// list = SJF/RR/priority queues
-    // cout<<"aging (sort"<<endl;
-    ListIterator<Thread *> *iter = new ListIterator<Thread *>((List<Thread *>*)list);
-    for (; !iter->IsDone(); iter->Next()) {
-        Thread* thread = iter->Item();
-        if(!list->IsInList(thread))break;//
-        list->Remove(thread);
-        if(kernel->stats->totalTicks - thread->getReadyTime() >= 1500){
-            thread->setReadyTime(kernel->stats->totalTicks);
-            thread->setPriority(thread->getPriority()+10);
-        }
-        moveBetweenQueues(thread);
-        
+BandQueue::aging()// OAO
+{
+    Thread *thread;
+    unsigned int bits;
+    int level, due;
+
+    if (kernel->stats->totalTicks < nextAging)
+	return;
+    nextAging = kernel->stats->totalTicks + AgingInterval;	// at the latest
+    for (int w = 0; w < PriorityMapWords; w++) {
+	bits = priorityMap[w];
+	while (bits != 0) {
+	    level = NumPriorityLevels - 1 
+			- (w * BitsInWord + __builtin_ffs(bits) - 1);
+	    bits &= bits - 1;		// on to the next set bit
+	    while (!readyList[level]->IsEmpty()) {
+		thread = readyList[level]->Front();
+		due = thread->getReadyTime() + AgingInterval;
+		if (kernel->stats->totalTicks < due) {
+		    nextAging = min(nextAging, due);
+		    break;
+		}
+		readyList[level]->RemoveFront();
+		numReady--;
+		thread->setReadyTime(kernel->stats->totalTicks);
+		thread->setPriority(thread->getPriority() + AgingStep);
+		moveBetweenQueues(thread);
+	    }
+	    if (readyList[level]->IsEmpty())
+		ClearLevel(level);
+	}
     }
 }
 
+//----------------------------------------------------------------------
+// BandQueue::moveBetweenQueues
+// 	Append "thread" to the queue of the band its priority falls in.
+//----------------------------------------------------------------------
 
+void BandQueue::moveBetweenQueues(Thread* thread)//OAO
+{
+    int priority = thread->getPriority();
 
-// not reach
-// void
-// Scheduler::aging(List<Thread*>* list)// OAO
-// {// list = SJF/RR/priority queues
-//     // cout<<"aging"<<endl;
-//     ListIterator<Thread *> *iter = new ListIterator<Thread *>((List<Thread *>*)list);
-//     for (; !iter->IsDone(); iter->Next()) {
-//         Thread* thread = iter->Item();
-//         if(!list->IsInList(thread))break;//
-//         list->Remove(thread);
-//         if(kernel->stats->totalTicks - thread->getReadyTime() >= 1500){
-//             thread->setReadyTime(kernel->stats->totalTicks);
-//             thread->setPriority(thread->getPriority()+10);
-//         }
-//         moveBetweenQueues(thread);
-//     }
-//     // cout<<"end aging"<<endl;
-// }
-void Scheduler::moveBetweenQueues(Thread* thread)//OAO
-{
-    // move between queues
-    // cout<<"MBQ!!!"<<endl;
-    if(thread->getPriority()>=100){
-        // SJF
-        //thr
-        cout<<"Tick "<<kernel->stats->totalTicks<<" Thread "<<thread->getID()<<" move to SJF queue"<<endl;
+    if (priority >= 100) {
+        kernel->Trace(TraceQueue, thread, READY, READY, TraceSJFQueue);
         readySJFList->Insert(thread);
     }
-    else if(thread->getPriority()>=60){
-        // RR
-        cout<<"Tick "<<kernel->stats->totalTicks<<" Thread "<<thread->getID()<<" move to RR queue"<<endl;
+    else if (priority >= 60) {
+        kernel->Trace(TraceQueue, thread, READY, READY, TraceRRQueue);
         readyRRList->Append(thread);
     }
-    else{
-        // Priority Q
-        cout<<"Tick "<<kernel->stats->totalTicks<<" Thread "<<thread->getID()<<" move to Priority queue"<<endl;
-        readyList->Insert(thread);
+    else {
+        kernel->Trace(TraceQueue, thread, READY, READY, TracePriorityQueue);
+        readyList[priority]->Append(thread);
+        SetLevel(priority);
+        nextAging = min(nextAging, thread->getReadyTime() + AgingInterval);
+    }
+    numReady++;
+}
+
+//----------------------------------------------------------------------
+// BandQueue::SetLevel, ClearLevel
+// 	Record whether priority "level" has a thread ready.  Bit 0 of
+//	word 0 stands for the highest level.
+//----------------------------------------------------------------------
+
+void
+BandQueue::SetLevel(int level)
+{
+    int bit = NumPriorityLevels - 1 - level;
+
+    priorityMap[bit / BitsInWord] |= (unsigned int) 1 << (bit % BitsInWord);
+}
+
+void
+BandQueue::ClearLevel(int level)
+{
+    int bit = NumPriorityLevels - 1 - level;
+
+    priorityMap[bit / BitsInWord] &= ~((unsigned int) 1 << (bit % BitsInWord));
+}
+
+//----------------------------------------------------------------------
+// BandQueue::HighestLevel
+// 	Return the highest priority level with a thread ready, or -1 if
+//	the priority band is empty: the first set bit in priorityMap.
+//----------------------------------------------------------------------
+
+int
+BandQueue::HighestLevel()
+{
+    for (int w = 0; w < PriorityMapWords; w++)
+	if (priorityMap[w] != 0)
+	    return NumPriorityLevels - 1 
+			- (w * BitsInWord + __builtin_ffs(priorityMap[w]) - 1);
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// FairWeight
+// 	Return the weight of a thread of priority "priority", for the 
+//	-cfs policy: NiceZeroWeight at NiceZeroPriority, and 1.25 times 
+//	more (or less) for every NicePriorityStep above (or below) it.
+//----------------------------------------------------------------------
+
+int
+FairWeight(int priority)
+{
+    int weight = NiceZeroWeight;
+
+    for (int p = NiceZeroPriority; p + NicePriorityStep <= priority; 
+						p += NicePriorityStep)
+	weight = weight * 5 / 4;
+    for (int p = NiceZeroPriority; p - NicePriorityStep >= priority; 
+						p -= NicePriorityStep)
+	weight = weight * 4 / 5;
+    return weight;
+}
+
+//----------------------------------------------------------------------
+// FairQueue::FairQueue
+// 	Initialize an empty ready queue.
+//----------------------------------------------------------------------
+
+FairQueue::FairQueue()
+{
+    root = NULL;
+    minVruntime = 0;
+    totalWeight = 0;
+    nextOrder = 0;
+    numReady = 0;
+}
+
+//----------------------------------------------------------------------
+// FairQueue::~FairQueue
+// 	De-allocate the ready queue (but not the threads in it).
+//----------------------------------------------------------------------
+
+FairQueue::~FairQueue()
+{
+    while (RemoveFront() != NULL)
+	;
+}
+
+//----------------------------------------------------------------------
+// FairQueue::Insert
+// 	Put "thread" in the heap.
+//
+//	A thread can't bank CPU time by not using it: its virtual runtime
+//	is brought up to the least in the queue, so that a new thread, 
+//	or one that has slept for a long time, doesn't get the CPU to 
+//	itself for a long time.  A thread that just woke up is let off
+//	half of FairLatency, so interactive threads get to run soon.
+//
+//	"waking" is TRUE if the thread was blocked until now
+//----------------------------------------------------------------------
+
+void
+FairQueue::Insert(Thread *thread, bool waking)
+{
+    FairNode *node = new FairNode;
+    double floor = minVruntime;
+
+    if (waking)
+	floor -= FairLatency / 2;
+    if (thread->getVruntime() < floor)
+	thread->setVruntime(floor);
+
+    node->thread = thread;
+    node->weight = FairWeight(thread->getPriority());
+    node->order = nextOrder++;
+    node->child = NULL;
+    node->next = NULL;
+    root = Merge(root, node);
+    totalWeight += node->weight;
+    numReady++;
+}
+
+//----------------------------------------------------------------------
+// FairQueue::RemoveFront
+// 	Remove the thread with the least virtual runtime from the heap,
+//	and return it.  Return NULL if the heap is empty.
+//
+//	The children of the root are merged in pairs from left to right, 
+//	then the pairs from right to left (the standard two-pass 
+//	pairing), without recursion: the pairs are chained through 
+//	"next" on the way.
+//----------------------------------------------------------------------
+
+Thread *
+FairQueue::RemoveFront()
+{
+    FairNode *node = root, *pairs = NULL, *a, *b, *rest;
+    Thread *thread;
+
+    if (node == NULL)
+	return NULL;
+    for (a = node->child; a != NULL; a = rest) {
+	b = a->next;
+	rest = (b == NULL) ? NULL : b->next;
+	a->next = NULL;
+	if (b != NULL)
+	    b->next = NULL;
+	a = Merge(a, b);
+	a->next = pairs;
+	pairs = a;
+    }
+    root = NULL;
+    while (pairs != NULL) {
+	a = pairs;
+	pairs = a->next;
+	a->next = NULL;
+	root = Merge(a, root);
+    }
+
+    thread = node->thread;
+    if (thread->getVruntime() > minVruntime)
+	minVruntime = thread->getVruntime();
+    totalWeight -= node->weight;
+    numReady--;
+    delete node;
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// FairQueue::Merge
+// 	Merge two heaps, and return the result: the root with the larger
+//	virtual runtime becomes the first child of the other one.  Either
+//	may be NULL.
+//----------------------------------------------------------------------
+
+FairNode *
+FairQueue::Merge(FairNode *a, FairNode *b)
+{
+    FairNode *t;
+
+    if (a == NULL)
+	return b;
+    if (b == NULL)
+	return a;
+    if (b->thread->getVruntime() < a->thread->getVruntime() 
+	    || (b->thread->getVruntime() == a->thread->getVruntime() 
+		&& b->order < a->order)) {
+	t = a;
+	a = b;
+	b = t;
+    }
+    b->next = a->child;
+    a->child = b;
+    return a;
+}
+
+//----------------------------------------------------------------------
+// FairQueue::TimeSlice
+// 	Return how long "thread" may run: its share, by weight, of 
+//	FairLatency -- stretched if there are so many threads that the 
+//	slices would get shorter than the minimum granularity.
+//----------------------------------------------------------------------
+
+int
+FairQueue::TimeSlice(Thread *thread)
+{
+    int weight = FairWeight(thread->getPriority());
+    int period = max(FairLatency, kernel->minGranularity * (numReady + 1));
+
+    return max(kernel->minGranularity, 
+			period * weight / (totalWeight + weight));
+}
+
+//----------------------------------------------------------------------
+// FairQueue::Preempts
+// 	Return TRUE if "thread", just woken up, is behind "running" by
+//	more than the wakeup granularity.  "running" has just been 
+//	charged for the time it has run.
+//----------------------------------------------------------------------
+
+bool
+FairQueue::Preempts(Thread *thread, Thread *running)
+{
+    return thread->getVruntime() + kernel->wakeupGranularity 
+						< running->getVruntime();
+}
+
+//----------------------------------------------------------------------
+// FairQueue::Print
+// 	Print the threads in the queue, in no particular order.
+//----------------------------------------------------------------------
+
+void
+FairQueue::Print()
+{
+    PrintNode(root);
+}
+
+void
+FairQueue::PrintNode(FairNode *node)
+{
+    for (; node != NULL; node = node->next) {
+	ThreadPrint(node->thread);
+	PrintNode(node->child);
+    }
+}
+
+//----------------------------------------------------------------------
+// BurstHeap::BurstHeap
+// 	Initialize an empty heap of threads.
+//----------------------------------------------------------------------
+
+BurstHeap::BurstHeap()
+{
+    size = 8;
+    items = new Thread *[size];
+    order = new int[size];
+    numItems = 0;
+    nextOrder = 0;
+}
+
+//----------------------------------------------------------------------
+// BurstHeap::~BurstHeap
+// 	De-allocate the heap (but not the threads in it).
+//----------------------------------------------------------------------
+
+BurstHeap::~BurstHeap()
+{
+    delete [] items;
+    delete [] order;
+}
+
+//----------------------------------------------------------------------
+// BurstHeap::Insert
+// 	Put "thread" in the heap, growing it if needed, and sift it up.
+//----------------------------------------------------------------------
+
+void
+BurstHeap::Insert(Thread *thread)
+{
+    int i, parent;
+
+    if (numItems == size) {
+	Thread **newItems = new Thread *[2 * size];
+	int *newOrder = new int[2 * size];
+
+	for (i = 0; i < numItems; i++) {
+	    newItems[i] = items[i];
+	    newOrder[i] = order[i];
+	}
+	delete [] items;
+	delete [] order;
+	items = newItems;
+	order = newOrder;
+	size *= 2;
+    }
+    i = numItems++;
+    items[i] = thread;
+    order[i] = nextOrder++;
+    for (; i > 0; i = parent) {
+	parent = (i - 1) / 2;
+	if (!Before(i, parent))
+	    break;
+	Swap(i, parent);
+    }
+}
+
+//----------------------------------------------------------------------
+// BurstHeap::RemoveFront
+// 	Remove the thread with the shortest burst time from the heap, and
+//	return it.  Return NULL if the heap is empty.
+//----------------------------------------------------------------------
+
+Thread *
+BurstHeap::RemoveFront()
+{
+    Thread *thread;
+    int i, child;
+
+    if (numItems == 0)
+	return NULL;
+    thread = items[0];
+    numItems--;
+    items[0] = items[numItems];
+    order[0] = order[numItems];
+    for (i = 0; (child = 2 * i + 1) < numItems; i = child) {
+	if (child + 1 < numItems && Before(child + 1, child))
+	    child++;
+	if (!Before(child, i))
+	    break;
+	Swap(i, child);
     }
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// BurstHeap::Apply
+// 	Call "f" on every thread in the heap, in no particular order.
+//----------------------------------------------------------------------
+
+void
+BurstHeap::Apply(void (*f)(Thread *))
+{
+    for (int i = 0; i < numItems; i++)
+	f(items[i]);
+}
+
+//----------------------------------------------------------------------
+// BurstHeap::Before
+// 	Return TRUE if item "i" should be scheduled before item "j":
+//	it has the shorter burst time, or the same one and was inserted
+//	first (cf. Thread::compare_by_burst).  With -srtf, what counts 
+//	is the remaining burst time.
+//----------------------------------------------------------------------
+
+bool
+BurstHeap::Before(int i, int j)
+{
+    int cmp;
+    double ri, rj;
+
+    if (kernel->srtf) {
+	ri = RemainingBurst(items[i]);
+	rj = RemainingBurst(items[j]);
+	cmp = (ri < rj) ? -1 : (ri > rj) ? 1 : 0;
+    } else
+	cmp = Thread::compare_by_burst(items[i], items[j]);
+    return cmp < 0 || (cmp == 0 && order[i] < order[j]);
+}
+
+//----------------------------------------------------------------------
+// BurstHeap::Swap
+// 	Exchange items "i" and "j".
+//----------------------------------------------------------------------
+
+void
+BurstHeap::Swap(int i, int j)
+{
+    Thread *thread = items[i];
+    int n = order[i];
 
-    // cout<<"MBQ end!!!"<<endl;
+    items[i] = items[j];
+    order[i] = order[j];
+    items[j] = thread;
+    order[j] = n;
 }
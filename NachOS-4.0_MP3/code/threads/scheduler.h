@@ -11,11 +11,184 @@
 
 #include "copyright.h"
 #include "list.h"
+#include "bitmap.h"
 #include "thread.h"
+#include "cpu.h"
+
+// There are two scheduling policies, each with its own kind of ready
+// queue.  By default, ready threads are kept in three bands, by
+// priority:
+//
+//	100 ~ 149	SJF -- shortest (estimated) burst first
+//	 60 ~  99	round robin
+//	  0 ~  59	priority -- highest priority first
+//
+// and a thread is only picked from a band if the bands above it are
+// empty.  Threads in the priority band that have waited too long are
+// "aged" to a higher priority, and may move up into the RR band.
+//
+// The SJF band uses each thread's estimated CPU burst: an average of
+// its past bursts, weighted towards the recent ones by -alpha.  A burst
+// lasts until the thread blocks, however many time slices it takes.
+// With -srtf, a thread arriving in the SJF band preempts the running
+// SJF thread if it is expected to finish its burst sooner.
+//
+// With the -cfs flag, the scheduler is "completely fair" instead: the
+// thread that has had the least CPU time so far runs next.  CPU time
+// is weighted by priority (a thread NicePriorityStep higher gets 1.25
+// times the share), giving each thread a "virtual runtime".  Time
+// slices are cut so that every ready thread gets its share within 
+// FairLatency ticks, but are never shorter than the minimum 
+// granularity.  A thread that wakes up preempts the running thread 
+// if it is behind by more than the wakeup granularity.
+
+#define NumPriorityLevels	60	// levels in the priority band
+#define AgingInterval		1500	// ticks a thread waits to be aged
+#define AgingStep		10	// how much its priority goes up
+#define PriorityMapWords	divRoundUp(NumPriorityLevels, BitsInWord)
+
+#define NiceZeroPriority	75	// default priority: runs at weight
+#define NiceZeroWeight		1024	// NiceZeroWeight, so its virtual 
+					// runtime goes up one per tick
+#define NicePriorityStep	7	// priority steps per 1.25x weight
+#define FairLatency		1500	// ticks for all ready threads to run
+#define MinGranularity		100	// default shortest time slice
+#define WakeupGranularity	50	// default lead needed to preempt
+
+// The following class defines the SJF band: a binary heap of threads,
+// ordered by estimated burst time.  Threads with the same burst time
+// come out in the order they went in.
+
+class BurstHeap {
+  public:
+    BurstHeap();			// Initialize an empty heap
+    ~BurstHeap();
+
+    void Insert(Thread *thread);
+    Thread *RemoveFront();		// NULL if the heap is empty
+    bool IsEmpty() { return numItems == 0; }
+    void Apply(void (*f)(Thread *));	// call f on every thread
+
+  private:
+    Thread **items;			// the heap
+    int *order;				// insertion number of each item
+    int numItems;
+    int size;				// # of slots in "items"
+    int nextOrder;			// to number the next insertion
+
+    bool Before(int i, int j);		// should item i come out first?
+    void Swap(int i, int j);
+};
+
+// The following class defines the ready queue of one CPU, whatever
+// the scheduling policy.
+
+class ReadyQueue {
+  public:
+    virtual ~ReadyQueue() {}
+
+    virtual void Insert(Thread *thread, bool waking) = 0;
+				// put a ready thread on the queue;
+				// "waking" if it was blocked until now
+    virtual Thread *RemoveFront() = 0;
+				// next thread to run, or NULL
+    virtual void Update() {}	// called before a thread is picked
+    virtual int TimeSlice(Thread *thread);
+				// how long "thread" gets to run
+    virtual bool Preempts(Thread *thread, Thread *running);
+				// should "thread", just woken up, take
+				// over from "running"?
+    virtual void Print() = 0;	// Print the threads in the queue
+    int NumReady() { return numReady; }
+
+  protected:
+    int numReady;		// # of threads in the queue
+};
+
+// The following class defines a ready queue with the three bands 
+// described above.
+
+class BandQueue : public ReadyQueue {
+  public:
+    BandQueue();		// Initialize an empty queue
+    ~BandQueue();
+
+    void Insert(Thread *thread, bool waking) 
+	{ moveBetweenQueues(thread); }
+    Thread *RemoveFront();
+    void Update() { aging(); }
+    bool Preempts(Thread *thread, Thread *running);
+    void Print();
+
+    void moveBetweenQueues(Thread*);// put a thread in its band's queue
+    void aging();		// age the priority band
+
+  private:
+    IntrusiveList<Thread> *readyRRList;// RR band
+    BurstHeap *readySJFList;	// SJF band
+    IntrusiveList<Thread> *readyList[NumPriorityLevels];
+				// priority band: one FIFO per level
+    unsigned int priorityMap[PriorityMapWords];
+				// which levels have a thread ready; bit
+				// 0 of word 0 is the highest level, so
+				// the first set bit is the next to run
+    int nextAging;		// no thread in the priority band is due
+				// to be aged before this tick
+
+    void SetLevel(int level);	// maintain priorityMap
+    void ClearLevel(int level);
+    int HighestLevel();		// highest level with a thread, or -1
+};
+
+// The following class defines a node of the pairing heap in a FairQueue.
+
+class FairNode {
+  public:
+    Thread *thread;
+    int weight;			// of the thread, when it was queued
+    int order;			// insertion number, to break ties
+    FairNode *child;		// first child
+    FairNode *next;		// next sibling
+
+    void *operator new(size_t size) { return FreeList<FairNode>::Alloc(); }
+    void operator delete(void *p) { FreeList<FairNode>::Free(p); }
+};
+
+// The following class defines a ready queue for the -cfs policy: a
+// pairing heap of threads, ordered by virtual runtime.  Threads with
+// the same virtual runtime come out in the order they went in.
+
+class FairQueue : public ReadyQueue {
+  public:
+    FairQueue();		// Initialize an empty queue
+    ~FairQueue();
+
+    void Insert(Thread *thread, bool waking);
+    Thread *RemoveFront();
+    int TimeSlice(Thread *thread);
+    bool Preempts(Thread *thread, Thread *running);
+    void Print();
+
+  private:
+    FairNode *root;		// the heap, NULL if empty
+    double minVruntime;		// least virtual runtime seen at the 
+				// front; never goes down
+    int totalWeight;		// of the threads in the queue
+    int nextOrder;		// to number the next insertion
+
+    static FairNode *Merge(FairNode *a, FairNode *b);
+    static void PrintNode(FairNode *node);
+};
+
+extern int FairWeight(int priority);	// weight of a thread, by priority
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
 // thread is running, and which threads are ready but not running.
+//
+// There is one ready queue per simulated CPU.  A thread goes back to
+// the queue of the CPU it last ran on; a CPU with nothing to do steals
+// work from the busiest queue.
 
 class Scheduler {
   public:
@@ -32,19 +205,59 @@ class Scheduler {
     				// running needs to be deleted
     void Print();		// Print contents of ready list
     
+    void NextCpu();		// Switch to the CPU furthest behind,
+				// if it isn't the current one
+    bool IdleCpu(bool finishing);
+				// Leave the current CPU idle and switch 
+				// to another busy one, if any
+    int CpuTime();		// Clock of the busy CPU furthest behind
+    int NumReady();		// # of threads ready, on any CPU
+
+    int TimeSlice(Thread *thread);
+				// How long "thread" may run on the 
+				// current CPU
+    void Charge(Thread *thread);// Add the CPU time "thread" has used
+				// since it was last charged to its 
+				// burst and virtual runtime
+    void EndBurst(Thread *thread);
+				// "thread" is blocking: update its
+				// estimated burst time
+    bool SlicesByClock();	// are time slices kept per tick?
+
+    void Finished(Thread *thread);
+				// "thread" is done: count it in the 
+				// turnaround and waiting times
+    void PrintStats();		// Print them, at Halt
+
     // SelfTest for scheduler is implemented in class Thread
     
   private:
-    void aging(SortedList<Thread*>*);//OAO
-    // void aging(List<Thread*>*);// OAO work item 2
-    void moveBetweenQueues(Thread*);// work item 2 (1) OAO
-    List<Thread *>*readyRRList;// OAO 2-1
-    SortedList<Thread *> *readySJFList;// OAO 2-2
-    // OAO priority queue
-    SortedList<Thread *> *readyList;  // queue of threads that are ready to run,
-				// but not running
+    ReadyQueue *queues[MaxCpus];// one per CPU
     Thread *toBeDestroyed;	// finishing thread to be destroyed
     				// by the next thread that runs
+    int numFinished;		// # of threads that have finished
+    double totalTurnaround;	// their total turnaround time
+    double totalWaiting;	// and total waiting time
+    int *turnarounds;		// each one's turnaround time, for
+				// percentiles
+    int maxTurnarounds;		// size of "turnarounds"
+    int Percentile(int p);	// "p"th percentile turnaround time,
+				// once "turnarounds" is sorted
+
+    void Dispatch(Thread *thread, Cpu *cpu);
+				// start running "thread" on "cpu"
+
+    int QueueFor(Thread *thread);// which CPU's queue a ready thread 
+				// goes on
+    void CheckPreempt(int cpu, Thread *thread);
+				// does "thread", just woken up, preempt
+				// the thread running on "cpu"?
+    Thread *Steal(int cpu);	// take a thread from the busiest queue
+    void SwitchCpu(Cpu *to, Thread *nextThread);
+				// make "to" the current CPU
+    void Switch(Thread *oldThread, Thread *nextThread);
+				// context switch, common to Run and 
+				// SwitchCpu
 };
 
 #endif // SCHEDULER_H
@@ -28,6 +28,9 @@
 // The implementation of condition variables using semaphores is
 // a bit trickier, as explained below under Condition::Wait.
 //
+// Reader-writer locks are a monitor: a lock protecting the counts of
+// readers and writers, and a condition variable for each to wait on.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -48,7 +51,7 @@ Semaphore::Semaphore(char* debugName, int initialValue)
 {
     name = debugName;
     value = initialValue;
-    queue = new List<Thread *>;
+    queue = new IntrusiveList<Thread>;
 }
 
 //----------------------------------------------------------------------
@@ -295,3 +298,351 @@ void Condition::Broadcast(Lock* conditionLock)
         Signal(conditionLock);
     }
 }
+
+// Names of the lock and conditions inside every RWLock
+static char rwLockName[] = "rwlock";
+static char rwReadersName[] = "rwlock readers";
+static char rwWritersName[] = "rwlock writers";
+
+//----------------------------------------------------------------------
+// RWLock::RWLock
+// 	Initialize a reader-writer lock, so that it can be used for 
+//	synchronization.  Initially, no one is reading or writing.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+RWLock::RWLock(char* debugName)
+{
+    name = debugName;
+    lock = new Lock(rwLockName);
+    readersGo = new Condition(rwReadersName);
+    writersGo = new Condition(rwWritersName);
+    numReading = 0;
+    writing = FALSE;
+    writer = NULL;
+    readersWaiting = 0;
+    writersWaiting = 0;
+}
+
+//----------------------------------------------------------------------
+// RWLock::~RWLock
+// 	Deallocate a reader-writer lock.  Assume no one is using it!
+//----------------------------------------------------------------------
+
+RWLock::~RWLock()
+{
+    ASSERT(numReading == 0 && !writing);
+    delete lock;
+    delete readersGo;
+    delete writersGo;
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireRead
+//	Wait until no thread is writing, or waiting to write, then start
+//	reading.  A reader that has to wait is let in by ReleaseWrite,
+//	which counts it among the readers before waking it up.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireRead()
+{
+    lock->Acquire();
+    if (writing || writersWaiting > 0) {
+	readersWaiting++;
+	readersGo->Wait(lock);		// ReleaseWrite lets us in
+	ASSERT(numReading > 0 && !writing);
+    } else {
+	numReading++;
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseRead
+//	Stop reading.  If this was the last reader, and a writer is
+//	waiting, hand the lock over to it.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseRead()
+{
+    lock->Acquire();
+    ASSERT(numReading > 0);
+    numReading--;
+    if (numReading == 0 && writersWaiting > 0) {
+	writersWaiting--;
+	writing = TRUE;
+	writersGo->Signal(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::AcquireWrite
+//	Wait until no thread is reading or writing, then start writing.
+//	A writer that has to wait is handed the lock by the thread that
+//	leaves it free.
+//----------------------------------------------------------------------
+
+void
+RWLock::AcquireWrite()
+{
+    lock->Acquire();
+    if (writing || numReading > 0) {
+	writersWaiting++;
+	writersGo->Wait(lock);		// we are handed the lock
+	ASSERT(writing && numReading == 0);
+    } else {
+	writing = TRUE;
+    }
+    writer = kernel->currentThread;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::ReleaseWrite
+//	Stop writing.  Let in all the readers that waited while we
+//	wrote, or if there are none, the next writer.
+//
+//	By convention, only the thread that is writing may call this.
+//----------------------------------------------------------------------
+
+void
+RWLock::ReleaseWrite()
+{
+    lock->Acquire();
+    ASSERT(IsWriteHeldByCurrentThread());
+    writing = FALSE;
+    writer = NULL;
+    if (readersWaiting > 0) {
+	numReading = readersWaiting;
+	readersWaiting = 0;
+	readersGo->Broadcast(lock);
+    } else if (writersWaiting > 0) {
+	writersWaiting--;
+	writing = TRUE;
+	writersGo->Signal(lock);
+    }
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// RWLock::SelfTest, RWReader, RWWriter, RWOrdered
+// 	Test the reader-writer lock implementation.  First, readers and
+//	writers take turns, yielding the CPU while they hold the lock,
+//	and check that no one writes while anyone else reads or writes.
+//	Then, check the order in which waiting threads get in: a reader
+//	that arrives after a writer starts waiting goes after it, and
+//	readers that wait during a write go before the next writer.
+//----------------------------------------------------------------------
+
+static RWLock *rwTest;
+static int rwReaders, rwWriters;	// # of threads in each role
+static char rwOrder[4];			// which roles got in, in order
+static int rwNumOrdered;
+static Semaphore *rwDone;
+static char rwDoneName[] = "rwlock test";
+static char readerName[] = "reader";
+static char writerName[] = "writer";
+
+static void
+RWReader(int which)
+{
+    for (int i = 0; i < 10; i++) {
+	rwTest->AcquireRead();
+	rwReaders++;
+	ASSERT(rwWriters == 0);
+	kernel->currentThread->Yield();
+	ASSERT(rwWriters == 0);
+	rwReaders--;
+	rwTest->ReleaseRead();
+	kernel->currentThread->Yield();
+    }
+    rwDone->V();
+}
+
+static void
+RWWriter(int which)
+{
+    for (int i = 0; i < 10; i++) {
+	rwTest->AcquireWrite();
+	ASSERT(rwTest->IsWriteHeldByCurrentThread());
+	rwWriters++;
+	ASSERT(rwWriters == 1 && rwReaders == 0);
+	kernel->currentThread->Yield();
+	ASSERT(rwWriters == 1 && rwReaders == 0);
+	rwWriters--;
+	rwTest->ReleaseWrite();
+	kernel->currentThread->Yield();
+    }
+    rwDone->V();
+}
+
+static void
+RWOrdered(int write)
+{
+    if (write) {
+	rwTest->AcquireWrite();
+	rwOrder[rwNumOrdered++] = 'w';
+	rwTest->ReleaseWrite();
+    } else {
+	rwTest->AcquireRead();
+	rwOrder[rwNumOrdered++] = 'r';
+	rwTest->ReleaseRead();
+    }
+    rwDone->V();
+}
+
+void
+RWLock::SelfTest()
+{
+    int i;
+
+    ASSERT(numReading == 0 && !writing);	// otherwise test won't work!
+    rwTest = this;
+    rwDone = new Semaphore(rwDoneName, 0);
+
+    rwReaders = rwWriters = 0;
+    for (i = 0; i < 3; i++)
+	(new Thread(readerName, 1))->Fork((VoidFunctionPtr) RWReader, 
+						(void *) (long) i);
+    for (i = 0; i < 2; i++)
+	(new Thread(writerName, 1))->Fork((VoidFunctionPtr) RWWriter, 
+						(void *) (long) i);
+    for (i = 0; i < 5; i++)
+	rwDone->P();
+
+    // while we read: a writer waits, then a reader waits behind it
+    rwNumOrdered = 0;
+    AcquireRead();
+    (new Thread(writerName, 1))->Fork((VoidFunctionPtr) RWOrdered, (void *) 1);
+    while (writersWaiting == 0)
+	kernel->currentThread->Yield();
+    (new Thread(readerName, 1))->Fork((VoidFunctionPtr) RWOrdered, (void *) 0);
+    while (readersWaiting == 0)
+	kernel->currentThread->Yield();
+    ReleaseRead();
+    for (i = 0; i < 2; i++)
+	rwDone->P();
+    ASSERT(rwOrder[0] == 'w' && rwOrder[1] == 'r');
+
+    // while we write: a reader, a writer, and another reader wait
+    rwNumOrdered = 0;
+    AcquireWrite();
+    (new Thread(readerName, 1))->Fork((VoidFunctionPtr) RWOrdered, (void *) 0);
+    while (readersWaiting == 0)
+	kernel->currentThread->Yield();
+    (new Thread(writerName, 1))->Fork((VoidFunctionPtr) RWOrdered, (void *) 1);
+    while (writersWaiting == 0)
+	kernel->currentThread->Yield();
+    (new Thread(readerName, 1))->Fork((VoidFunctionPtr) RWOrdered, (void *) 0);
+    while (readersWaiting == 1)
+	kernel->currentThread->Yield();
+    ReleaseWrite();
+    for (i = 0; i < 3; i++)
+	rwDone->P();
+    ASSERT(rwOrder[0] == 'r' && rwOrder[1] == 'r' && rwOrder[2] == 'w');
+
+    ASSERT(numReading == 0 && !writing);
+    delete rwDone;
+}
+
+//----------------------------------------------------------------------
+// LockBenchmark, BenchThread, TimeLocks, Work
+// 	Time a group of threads sharing data under a Lock, and under an
+//	RWLock.  Each thread holds the lock for a while, then works a
+//	while without it, over and over; the data is only read, or 
+//	written one time in ten.  With -smp, readers sharing the RWLock
+//	run on all the CPUs at once, so reads get done several times as
+//	fast, while under the Lock they take turns however many CPUs
+//	there are.  With -rs, time slices end anywhere, including while
+//	a thread holds the lock.
+//----------------------------------------------------------------------
+
+const int BenchThreads = 8;		// # of threads sharing the data
+const int BenchOps = 50;		// # of times each takes the lock
+const int HoldTicks = 20;		// how long it holds the lock, and
+const int ThinkTicks = 5;		// works without it (in interrupt
+					// enables, each a SystemTick)
+
+static Lock *benchLock;			// the lock being timed: one of 
+static RWLock *benchRWLock;		// these is NULL
+static int benchWriteEvery;		// write every n'th time; 0 if never
+static Semaphore *benchDone;
+static char benchName[] = "bench";
+static char benchDoneName[] = "bench done";
+
+static void
+Work(int ticks)
+{
+    for (int i = 0; i < ticks; i++) {
+	(void) kernel->interrupt->SetLevel(IntOff);
+	(void) kernel->interrupt->SetLevel(IntOn);	// time passes
+    }
+}
+
+static void
+BenchThread(int which)
+{
+    bool write;
+
+    for (int i = 0; i < BenchOps; i++) {
+	write = (benchWriteEvery > 0 && (i + which) % benchWriteEvery == 0);
+	if (benchLock != NULL)
+	    benchLock->Acquire();
+	else if (write)
+	    benchRWLock->AcquireWrite();
+	else
+	    benchRWLock->AcquireRead();
+	Work(HoldTicks);
+	if (benchLock != NULL)
+	    benchLock->Release();
+	else if (write)
+	    benchRWLock->ReleaseWrite();
+	else
+	    benchRWLock->ReleaseRead();
+	Work(ThinkTicks);
+    }
+    benchDone->V();
+}
+
+static int
+TimeLocks(bool readWrite, int writeEvery)
+{
+    int start = kernel->stats->totalTicks;
+
+    benchLock = readWrite ? NULL : new Lock(benchName);
+    benchRWLock = readWrite ? new RWLock(benchName) : NULL;
+    benchWriteEvery = writeEvery;
+    benchDone = new Semaphore(benchDoneName, 0);
+    for (int i = 0; i < BenchThreads; i++)
+	(new Thread(benchName, 1))->Fork((VoidFunctionPtr) BenchThread, 
+						(void *) (long) i);
+    for (int i = 0; i < BenchThreads; i++)
+	benchDone->P();
+    if (benchLock != NULL)
+	delete benchLock;
+    if (benchRWLock != NULL)
+	delete benchRWLock;
+    delete benchDone;
+    return kernel->stats->totalTicks - start;
+}
+
+void
+LockBenchmark()
+{
+    int writeEvery[] = { 0, 10 };
+    int lockTicks, rwTicks;
+
+    cout << "Lock vs. RWLock: " << BenchThreads << " threads, " << BenchOps
+	 << " times each, on " << kernel->numCpus << " CPU(s)\n";
+    for (int i = 0; i < 2; i++) {
+	lockTicks = TimeLocks(FALSE, writeEvery[i]);
+	rwTicks = TimeLocks(TRUE, writeEvery[i]);
+	cout << ((writeEvery[i] == 0) ? "reads only:    " : "1 write in 10: ")
+	     << "Lock " << lockTicks << " ticks, RWLock " << rwTicks 
+	     << " ticks (" << (double) lockTicks / rwTicks << "x)\n";
+    }
+}
@@ -5,7 +5,8 @@
 //	locks, and condition variables.  The implementation for
 //	semaphores is given; for the latter two, only the procedure
 //	interface is given -- they are to be implemented as part of 
-//	the first assignment.
+//	the first assignment.  Reader-writer locks are built on top of
+//	locks and condition variables.
 //
 //	Note that all the synchronization objects take a "name" as
 //	part of the initialization.  This is solely for debugging purposes.
@@ -50,7 +51,7 @@ class Semaphore {
   private:
     char* name;        // useful for debugging
     int value;         // semaphore value, always >= 0
-    List<Thread *> *queue;     
+    IntrusiveList<Thread> *queue;     
 		  	// threads waiting in P() for the value to be > 0
    };
 
@@ -141,4 +142,61 @@ class Condition {
     char* name;
     List<Semaphore *> *waitQueue;	// list of waiting threads
 };
+
+// The following class defines a "reader-writer lock", for data that is
+// read much more often than it is changed.  Any number of threads
+// may hold it to read, at the same time, but a thread holding it to
+// write holds it alone:
+//
+//	AcquireRead -- wait until no thread is writing (or waiting to
+//		write), then start reading
+//
+//	ReleaseRead -- stop reading; the last reader out lets in a 
+//		waiting writer, if any
+//
+//	AcquireWrite -- wait until no thread is reading or writing, then
+//		start writing
+//
+//	ReleaseWrite -- stop writing, letting in every waiting reader,
+//		or if there are none, the next waiting writer
+//
+// Writers come first: once a writer is waiting, new readers wait 
+// behind it, so a stream of readers can't keep it out.  But the
+// readers that waited during a write all get in when it is done, 
+// ahead of any other writer, so a stream of writers can't keep them
+// out either.  Waiting threads are let in by handing them the lock
+// directly, rather than waking them to compete for it, so with Mesa
+// semantics no other thread can slip in ahead of them.
+
+class RWLock {
+  public:
+    RWLock(char* debugName);		// initialize lock to be FREE
+    ~RWLock();				// deallocate lock
+    char* getName() { return name; }	// debugging assist
+
+    void AcquireRead();			// these are the only operations
+    void ReleaseRead();			// on a reader-writer lock; they 
+    void AcquireWrite();		// are all *atomic*
+    void ReleaseWrite();
+
+    bool IsWriteHeldByCurrentThread() {
+		return writer == kernel->currentThread; }
+					// is the current thread writing?
+
+    void SelfTest();			// test the implementation
+
+  private:
+    char *name;				// debugging assist
+    Lock *lock;				// protects the fields below
+    Condition *readersGo;		// where readers wait
+    Condition *writersGo;		// where writers wait
+    int numReading;			// # of threads holding it to read
+    bool writing;			// is a thread holding it to write?
+    Thread *writer;			// if so, which one
+    int readersWaiting;			// # of threads in AcquireRead,
+    int writersWaiting;			// or AcquireWrite, waiting
+};
+
+extern void LockBenchmark();		// time readers and writers, using
+					// Lock and RWLock
 #endif // SYNCH_H
@@ -43,13 +43,21 @@ Thread::Thread(char* threadName, int threadID)
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
-    cout << "Thread " << ID << "\tProcessNew\t" << kernel->stats->totalTicks << endl;
+    kernel->Trace(TraceNew, this, JUST_CREATED, JUST_CREATED);
     for (int i = 0; i < MachineStateSize; i++) {
     machineState[i] = NULL;     // not strictly necessary, since
                     // new thread ignores contents 
                     // of machine registers
     }
     space = NULL;
+    listNext = NULL;
+    cpu = -1;
+    vruntime = 0;
+    runStart = 0;
+    burstSoFar = 0;
+    arrivalTime = kernel->stats->totalTicks;
+    waitStart = 0;
+    waitTicks = 0;
 }
 Thread::Thread(char* threadName, int threadID, int _priority)//OAO
 {
@@ -61,13 +69,21 @@ Thread::Thread(char* threadName, int threadID, int _priority)//OAO
     stackTop = NULL;
     stack = NULL;
     status = JUST_CREATED;
-    cout << "Thread " << ID << "\tProcessNew\t" << kernel->stats->totalTicks << endl;
+    kernel->Trace(TraceNew, this, JUST_CREATED, JUST_CREATED);
     for (int i = 0; i < MachineStateSize; i++) {
     machineState[i] = NULL;     // not strictly necessary, since
                     // new thread ignores contents 
                     // of machine registers
     }
     space = NULL;
+    listNext = NULL;
+    cpu = -1;
+    vruntime = 0;
+    runStart = 0;
+    burstSoFar = 0;
+    arrivalTime = kernel->stats->totalTicks;
+    waitStart = 0;
+    waitTicks = 0;
 }
 //----------------------------------------------------------------------
 // Thread::~Thread
@@ -85,8 +101,9 @@ Thread::~Thread()
 {
     DEBUG(dbgThread, "Deleting thread: " << name);
     ASSERT(this != kernel->currentThread);
+    kernel->processTable->Remove(this);
     if (stack != NULL)
-    DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+    DeallocStack((char *) stack, StackSize * sizeof(int));
 }
 
 //----------------------------------------------------------------------
@@ -195,7 +212,8 @@ Thread::Finish ()
     ASSERT(this == kernel->currentThread);
     
     DEBUG(dbgThread, "Finishing thread: " << name);
-    cout << "Thread " << kernel->currentThread->getID() << "\tProcessFinish\t" << kernel->stats->totalTicks << endl;
+    kernel->Trace(TraceFinish, this, RUNNING, ZOMBIE);
+    kernel->scheduler->Finished(this);
     Sleep(TRUE);                // invokes SWITCH
     // not reached
 }
@@ -234,6 +252,8 @@ Thread::Yield ()
     if (nextThread != NULL) {
         if(nextThread != kernel->currentThread){
             kernel->scheduler->Run(nextThread, FALSE);
+        } else {
+            setStatus(RUNNING);     // nobody else to run, carry on
         }
     }
     (void) kernel->interrupt->SetLevel(oldLevel);
@@ -268,11 +288,16 @@ Thread::Sleep (bool finishing)
     ASSERT(kernel->interrupt->getLevel() == IntOff);
     
     DEBUG(dbgThread, "Sleeping thread: " << name);
-    cout << "Thread " << kernel->currentThread->getID() << "\tProcessSleep\t" << kernel->stats->totalTicks << endl;
+    kernel->Trace(TraceSleep, this, RUNNING, finishing ? ZOMBIE : BLOCKED);
 
+    kernel->scheduler->Charge(this);
+    if (!finishing)
+        kernel->scheduler->EndBurst(this);
     status = BLOCKED;
     //cout << "debug Thread::Sleep " << name << "wait for Idle\n";
     while ((nextThread = kernel->scheduler->FindNextToRun()) == NULL) {
+        if (kernel->scheduler->IdleCpu(finishing))
+            return;             // another CPU ran until we were woken up
         kernel->interrupt->Idle();  // no one to run, wait for an interrupt
     }    
     // returns when it's time for us to run
@@ -317,8 +342,10 @@ PLabelToAddr(void *plabel)
 
 //----------------------------------------------------------------------
 // Thread::StackAllocate
-//  Allocate and initialize an execution stack.  The stack is
-//  initialized with an initial stack frame for ThreadRoot, which:
+//  Allocate and initialize an execution stack.  The stack comes 
+//  from a pool kept by AllocStack, with guard pages at either end
+//  to trap overflow (cf. sysdep.cc).  It is initialized with an
+//  initial stack frame for ThreadRoot, which:
 //      enables interrupts
 //      calls (*func)(arg)
 //      calls Thread::Finish
@@ -330,7 +357,7 @@ PLabelToAddr(void *plabel)
 void
 Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    stack = (int *) AllocStack(StackSize * sizeof(int));
 
 #ifdef PARISC
     // HP stack works from low addresses to high addresses
@@ -395,13 +422,17 @@ Thread::StackAllocate (VoidFunctionPtr func, void *arg)
 //  Note that a user program thread has *two* sets of CPU registers -- 
 //  one for its state while executing user code, one for its state 
 //  while executing kernel code.  This routine saves the former.
+//
+//  "machine" is the simulated CPU to save from; NULL for kernel->machine
 //----------------------------------------------------------------------
 
 void
-Thread::SaveUserState()
+Thread::SaveUserState(Machine *machine)
 {
+    if (machine == NULL)
+    machine = kernel->machine;
     for (int i = 0; i < NumTotalRegs; i++)
-    userRegisters[i] = kernel->machine->ReadRegister(i);
+    userRegisters[i] = machine->ReadRegister(i);
 }
 
 //----------------------------------------------------------------------
@@ -411,13 +442,17 @@ Thread::SaveUserState()
 //  Note that a user program thread has *two* sets of CPU registers -- 
 //  one for its state while executing user code, one for its state 
 //  while executing kernel code.  This routine restores the former.
+//
+//  "machine" is the simulated CPU to restore to; NULL for kernel->machine
 //----------------------------------------------------------------------
 
 void
-Thread::RestoreUserState()
+Thread::RestoreUserState(Machine *machine)
 {
+    if (machine == NULL)
+    machine = kernel->machine;
     for (int i = 0; i < NumTotalRegs; i++)
-    kernel->machine->WriteRegister(i, userRegisters[i]);
+    machine->WriteRegister(i, userRegisters[i]);
 }
 
 
@@ -466,7 +501,7 @@ bool Thread::setPriority(int _priority)// OAO
         return true;
     }
     priority=_priority;
-    cout<< "Tick " << kernel->stats->totalTicks << " Thread" << ID << " changes its priority to " << priority <<endl;
+    kernel->Trace(TracePriority, this, status, status, 0, priority);
     return true;
 }
 int Thread::getPriority()// OAO
@@ -488,7 +523,7 @@ bool Thread::setBurstTime(double _burstTime)//OAO
     // cout<<"setBurstTime = "<<kernel->stats->totalTicks<<" - "<<startBurstTime<<" + "<<_burstTime<<endl;
     // burstTime=(kernel->stats->totalTicks - startBurstTime + _burstTime)/2;
     burstTime=_burstTime;
-    cout<<"Tick "<<kernel->stats->totalTicks<<" Thread "<<this->getID()<<" change its burst time to "<<burstTime<<endl;
+    kernel->Trace(TraceBurst, this, status, status, 0, burstTime);
     if(burstTime<0)return false;
     return true;
 }
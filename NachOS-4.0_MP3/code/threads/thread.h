@@ -84,6 +84,15 @@ class Thread {
     double burstTime;// OAO
     // static int startBurstTime;//OAO
     int startBurstTime;//OAO?
+    int cpu;			// CPU the thread last ran on, or -1
+    double vruntime;		// weighted CPU time, for -cfs
+    int runStart;		// when the CPU time not yet charged
+				// (cf. Scheduler::Charge) started
+    int burstSoFar;		// CPU time of the current burst, over
+				// all the time slices it took
+    int arrivalTime;		// when the thread was created
+    int waitStart;		// when it last became ready
+    int waitTicks;		// total time spent ready, not running
   public:
     Thread(char* debugName, int threadID);      // initialize a Thread 
     Thread(char* threadName, int threadID, int _priority);// OAO initialize with priority
@@ -133,6 +142,19 @@ class Thread {
     }
     void setReadyTime(int);//OAO
     int getReadyTime();//OAO
+    void setCpu(int c) { cpu = c; }
+    int getCpu() { return cpu; }	// CPU it last ran on, or -1
+    void setVruntime(double v) { vruntime = v; }
+    double getVruntime() { return vruntime; }
+    void setRunStart(int t) { runStart = t; }
+    int getRunStart() { return runStart; }
+    void setBurstSoFar(int t) { burstSoFar = t; }
+    int getBurstSoFar() { return burstSoFar; }
+    int getArrivalTime() { return arrivalTime; }
+    void setWaitStart(int t) { waitStart = t; }
+    int getWaitStart() { return waitStart; }
+    void addWaitTicks(int t) { waitTicks += t; }
+    int getWaitTicks() { return waitTicks; }
   private:
     // some of the private data for this class is listed above
     
@@ -153,10 +175,16 @@ class Thread {
     int userRegisters[NumTotalRegs];    // user-level CPU register state
 
   public:
-    void SaveUserState();       // save user-level register state
-    void RestoreUserState();        // restore user-level register state
+    void SaveUserState(Machine *machine = NULL);
+                    // save user-level register state
+    void RestoreUserState(Machine *machine = NULL);
+                    // restore user-level register state
+                    // (from/to kernel->machine by default)
 
     AddrSpace *space;           // User code this thread is running.
+
+    Thread *listNext;		// next thread on the semaphore queue or
+				// ready queue it is on (cf. IntrusiveList)
 };
 
 // external function, dummy routine whose sole job is to call Thread::Print
@@ -0,0 +1,246 @@
+// tracecat.cc
+//	Print a trace file made by "nachos -trace", as the text Nachos
+//	prints without -trace (cf. lib/trace.h).
+//
+//	With -chrome, print it instead as a Chrome trace-event file
+//	(JSON), to load in chrome://tracing or ui.perfetto.dev.  Each
+//	thread is a track, spanning "ready", "running" and "blocked",
+//	with its queue, priority and burst changes as instant events.
+//	Interrupts and console reads are instant events on the device
+//	tracks; disk requests and console writes are async spans from
+//	request to completion.  One simulated tick is shown as one
+//	microsecond.
+//
+// Usage: tracecat [-chrome] <trace file>
+//
+// Build it in build.linux with "make tracecat".
+//
+// Copyright (c) 1992-1996 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "debug.h"
+#include "trace.h"
+#include "thread.h"
+
+#define EventsPerRead	4096		// events read at a time
+
+// Chrome trace "processes" and device "threads"
+enum { ThreadsPid = 1, DevicesPid = 2 };
+enum { InterruptTid, DiskTid, ConsoleTid };
+
+// cf. IntType in machine/interrupt.h
+static const char *intTypeNames[] = { "timer", "disk", "console write", 
+			"console read", "network send", "network recv",
+			"job arrival"};
+static const char *queueNames[] = { "SJF", "RR", "Priority" };
+static const char *stateNames[] = { "new", "running", "ready", "blocked",
+			"zombie" };	// cf. ThreadStatus in threads/thread.h
+
+Debug *debug;			// for the routines in sysdep.cc
+
+static bool firstRecord = TRUE;	// no comma before the first record
+static int diskRequests = 0;	// id of the current disk request
+static bool diskWriting;	// is it a write?
+static int consoleWrites = 0;	// id of the current console write
+
+//----------------------------------------------------------------------
+// ReadFully
+// 	Read up to "nBytes" from "fd", stopping early only at the end of
+//	the file.  Return the number of bytes read.
+//----------------------------------------------------------------------
+
+static int
+ReadFully(int fd, char *buffer, int nBytes)
+{
+    int done = 0, n;
+
+    while (done < nBytes) {
+	n = ReadPartial(fd, buffer + done, nBytes - done);
+	if (n <= 0)
+	    break;
+	done += n;
+    }
+    return done;
+}
+
+//----------------------------------------------------------------------
+// StartRecord
+// 	Begin a Chrome trace record: its phase, time, and track.  The
+//	caller adds any other fields, and closes the brace.
+//----------------------------------------------------------------------
+
+static void
+StartRecord(const char *phase, int tick, int pid, int tid)
+{
+    cout << (firstRecord ? "\n" : ",\n");
+    firstRecord = FALSE;
+    cout << "{\"ph\":\"" << phase << "\",\"ts\":" << tick 
+	 << ",\"pid\":" << pid << ",\"tid\":" << tid;
+}
+
+//----------------------------------------------------------------------
+// PrintName
+// 	Print a metadata record, naming a track.
+//----------------------------------------------------------------------
+
+static void
+PrintName(const char *what, int pid, int tid, const char *name, int id)
+{
+    StartRecord("M", 0, pid, tid);
+    cout << ",\"name\":\"" << what << "\",\"args\":{\"name\":\"" << name;
+    if (id >= 0)
+	cout << " " << id;
+    cout << "\"}}";
+}
+
+//----------------------------------------------------------------------
+// PrintChromeEvent
+// 	Print "event" as Chrome trace records.  A change of state ends
+//	the span for the old state (if there was one) and begins one for
+//	the new state.  A finishing thread's span ends at TraceFinish; 
+//	the TraceSleep that follows (to ZOMBIE) adds nothing.
+//----------------------------------------------------------------------
+
+static void
+PrintChromeEvent(TraceEvent *event)
+{
+    int t = event->tick;
+    int id = event->thread;
+
+    switch (event->kind) {
+      case TraceNew:
+	PrintName("thread_name", ThreadsPid, id, "Thread", id);
+	break;
+      case TraceReady:
+      case TraceRunning:
+      case TraceSleep:
+	if (event->to == ZOMBIE)
+	    break;
+	if (event->from != JUST_CREATED) {
+	    StartRecord("E", t, ThreadsPid, id);
+	    cout << "}";
+	}
+	StartRecord("B", t, ThreadsPid, id);
+	cout << ",\"name\":\"" << stateNames[event->to] << "\"}";
+	break;
+      case TraceFinish:
+	StartRecord("E", t, ThreadsPid, id);
+	cout << "}";
+	break;
+      case TraceQueue:
+	StartRecord("i", t, ThreadsPid, id);
+	cout << ",\"s\":\"t\",\"name\":\"to " << queueNames[event->queue] 
+	     << " queue\"}";
+	break;
+      case TracePriority:
+	StartRecord("i", t, ThreadsPid, id);
+	cout << ",\"s\":\"t\",\"name\":\"priority\",\"args\":{\"priority\":"
+	     << (int) event->value << "}}";
+	break;
+      case TraceBurst:
+	StartRecord("i", t, ThreadsPid, id);
+	cout << ",\"s\":\"t\",\"name\":\"burst estimate\",\"args\":{\"burst\":"
+	     << event->value << "}}";
+	break;
+      case TraceInterrupt:
+	StartRecord("i", t, DevicesPid, InterruptTid);
+	cout << ",\"s\":\"t\",\"name\":\"" << intTypeNames[event->queue]
+	     << "\",\"args\":{\"thread\":" << id << "}}";
+	break;
+      case TraceDiskStart:
+	diskRequests++;
+	diskWriting = event->queue;
+	StartRecord("b", t, DevicesPid, DiskTid);
+	cout << ",\"cat\":\"disk\",\"id\":" << diskRequests << ",\"name\":\"" 
+	     << (diskWriting ? "write" : "read") << "\",\"args\":{\"sector\":"
+	     << (int) event->value << ",\"thread\":" << id << "}}";
+	break;
+      case TraceDiskDone:
+	StartRecord("e", t, DevicesPid, DiskTid);
+	cout << ",\"cat\":\"disk\",\"id\":" << diskRequests << ",\"name\":\"" 
+	     << (diskWriting ? "write" : "read") << "\"}";
+	break;
+      case TraceConsoleWrite:
+	consoleWrites++;
+	StartRecord("b", t, DevicesPid, ConsoleTid);
+	cout << ",\"cat\":\"console\",\"id\":" << consoleWrites 
+	     << ",\"name\":\"write\",\"args\":{\"chars\":" 
+	     << (int) event->value << ",\"thread\":" << id << "}}";
+	break;
+      case TraceConsoleDone:
+	StartRecord("e", t, DevicesPid, ConsoleTid);
+	cout << ",\"cat\":\"console\",\"id\":" << consoleWrites 
+	     << ",\"name\":\"write\"}";
+	break;
+      case TraceConsoleRead:
+	StartRecord("i", t, DevicesPid, ConsoleTid);
+	cout << ",\"s\":\"t\",\"name\":\"read\",\"args\":{\"chars\":"
+	     << (int) event->value << "}}";
+	break;
+      default:
+	ASSERTNOTREACHED();
+    }
+}
+
+//----------------------------------------------------------------------
+// main
+// 	Check the magic number, then print the events one by one, as
+//	text or (with -chrome) as JSON.  A
+//	trace cut short (say, if Nachos crashed while writing it) is
+//	printed up to the last whole event.
+//----------------------------------------------------------------------
+
+int
+main(int argc, char **argv)
+{
+    TraceEvent *events;
+    int fd, magic, n;
+    bool chrome = FALSE;
+    char *fileName;
+
+    if (argc == 3 && strcmp(argv[1], "-chrome") == 0) 
+	chrome = TRUE;
+    else if (argc != 2) {
+	cerr << "Usage: tracecat [-chrome] <trace file>\n";
+	return 1;
+    }
+    fileName = argv[argc - 1];
+    fd = OpenForReadWrite(fileName, FALSE);
+    if (fd < 0) {
+	cerr << "tracecat: can't open " << fileName << "\n";
+	return 1;
+    }
+    if (ReadFully(fd, (char *) &magic, sizeof(int)) != sizeof(int)
+		|| magic != TraceMagic) {
+	cerr << "tracecat: " << fileName << " is not a Nachos trace\n";
+	return 1;
+    }
+
+    if (chrome) {
+	cout << "{\"traceEvents\":[";
+	PrintName("process_name", ThreadsPid, 0, "Threads", -1);
+	PrintName("process_name", DevicesPid, 0, "Devices", -1);
+	PrintName("thread_name", DevicesPid, InterruptTid, "Interrupts", -1);
+	PrintName("thread_name", DevicesPid, DiskTid, "Disk", -1);
+	PrintName("thread_name", DevicesPid, ConsoleTid, "Console", -1);
+    }
+
+    events = new TraceEvent[EventsPerRead];
+    do {
+	n = ReadFully(fd, (char *) events, EventsPerRead * sizeof(TraceEvent))
+					/ sizeof(TraceEvent);
+	for (int i = 0; i < n; i++) {
+	    if (chrome)
+		PrintChromeEvent(&events[i]);
+	    else
+		PrintTraceEvent(&events[i]);
+	}
+    } while (n == EventsPerRead);
+    if (chrome)
+	cout << "\n]}\n";
+    delete [] events;
+    Close(fd);
+    return 0;
+}
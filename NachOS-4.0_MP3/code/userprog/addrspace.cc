@@ -79,6 +79,8 @@ AddrSpace::AddrSpace()
     
     // zero out the entire address space
   //  bzero(kernel->machine->mainMemory, MemorySize);
+    for (int i = 0; i < MaxOpenFiles; i++)
+	openFiles[i] = NULL;
 }
 
 //----------------------------------------------------------------------
@@ -89,6 +91,8 @@ AddrSpace::AddrSpace()
 AddrSpace::~AddrSpace()
 {
    delete pageTable;
+   for (int i = 0; i < MaxOpenFiles; i++)
+	delete openFiles[i];		// close what the program left open
 }
 
 
@@ -269,12 +273,16 @@ void AddrSpace::SaveState()
 //	this address space can run.
 //
 //      For now, tell the machine where to find the page table.
+//
+//	"machine" is the simulated CPU to run on; NULL for kernel->machine
 //----------------------------------------------------------------------
 
-void AddrSpace::RestoreState() 
+void AddrSpace::RestoreState(Machine *machine) 
 {
-    kernel->machine->pageTable = pageTable;
-    kernel->machine->pageTableSize = numPages;
+    if (machine == NULL)
+	machine = kernel->machine;
+    machine->pageTable = pageTable;
+    machine->pageTableSize = numPages;
 }
 
 
@@ -328,6 +336,49 @@ AddrSpace::Translate(unsigned int vaddr, unsigned int *paddr, int isReadWrite)
     return NoException;
 }
 
+//----------------------------------------------------------------------
+// AddrSpace::AddFile
+//  Give the open file _file_ an OpenFileId in this address space, and
+//  return it.  Return -1 if all the ids are in use; the caller still
+//  owns _file_ then.
+//----------------------------------------------------------------------
+int
+AddrSpace::AddFile(OpenFile *file)
+{
+    for (int id = FirstFileId; id < MaxOpenFiles; id++)
+        if (openFiles[id] == NULL) {
+            openFiles[id] = file;
+            return id;
+        }
+    return -1;
+}
 
+//----------------------------------------------------------------------
+// AddrSpace::GetFile
+//  Return the open file with OpenFileId _id_, or NULL if there is none
+//  (the console ids have no OpenFile behind them).
+//----------------------------------------------------------------------
+OpenFile *
+AddrSpace::GetFile(int id)
+{
+    if (id < 0 || id >= MaxOpenFiles)
+        return NULL;
+    return openFiles[id];
+}
 
+//----------------------------------------------------------------------
+// AddrSpace::CloseFile
+//  Close the open file with OpenFileId _id_, freeing the id.
+//  Return FALSE if there was no such file.
+//----------------------------------------------------------------------
+bool
+AddrSpace::CloseFile(int id)
+{
+    OpenFile *file = GetFile(id);
 
+    if (file == NULL)
+        return FALSE;
+    delete file;
+    openFiles[id] = NULL;
+    return TRUE;
+}
@@ -17,6 +17,10 @@
 #include "filesys.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
+#define MaxOpenFiles		16	// per process, counting the console
+#define FirstFileId		2	// ids below are the console
+
+class Machine;
 
 class AddrSpace {
   public:
@@ -32,18 +36,28 @@ class AddrSpace {
                                         // been loaded
 
     void SaveState();			// Save/restore address space-specific
-    void RestoreState();		// info on a context switch 
+    void RestoreState(Machine *machine = NULL);
+					// info on a context switch; by 
+					// default, on kernel->machine
 
     // Translate virtual address _vaddr_
     // to physical address _paddr_. _mode_
     // is 0 for Read, 1 for Write.
     ExceptionType Translate(unsigned int vaddr, unsigned int *paddr, int mode);
 
+    // The process's open files, indexed by OpenFileId.  Ids 0 and 1 
+    // are the console (cf. syscall.h), so they are never handed out.
+    int AddFile(OpenFile *file);	// Return the new id, or -1 if
+					// the process has too many open
+    OpenFile *GetFile(int id);		// NULL if "id" isn't open
+    bool CloseFile(int id);		// FALSE if "id" isn't open
+
   private:
     TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+    OpenFile *openFiles[MaxOpenFiles];	// Files the process has open
 
     void InitRegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
@@ -4,8 +4,8 @@
 //	transfer back to here from user code:
 //
 //	syscall -- The user code explicitly requests to call a procedure
-//	in the Nachos kernel.  Right now, the only function we support is
-//	"Halt".
+//	in the Nachos kernel.  We support "Halt", "Exit", the file
+//	system calls (Create, Open, Read, Write, Close) and a few more.
 //
 //	exceptions -- The user code does something that the CPU can't handle.
 //	For instance, accessing memory that doesn't exist, arithmetic errors,
@@ -14,8 +14,7 @@
 //	Interrupts (which can also cause control to transfer from user
 //	code into the Nachos kernel) are handled elsewhere.
 //
-// For now, this only handles the Halt() system call.
-// Everything else core dumps.
+// Any other exception core dumps.
 //
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -23,6 +22,8 @@
 
 #include "copyright.h"
 #include "main.h"
+#include "synchconsole.h"	// before syscall.h, which #defines 
+				// ConsoleInput/ConsoleOutput
 #include "syscall.h"
 #include "ksyscall.h"
 //----------------------------------------------------------------------
@@ -95,18 +96,66 @@ ExceptionHandler(ExceptionType which)
 			return;	
 			ASSERTNOTREACHED();
             break;
-    case SC_Nice:// 2-2 OAO change startBurstTime, burstTime
+    case SC_Nice:// 2-2 OAO
     		val=kernel->machine->ReadRegister(4);
-    		//OAO ?
-    		kernel->currentThread->setBurstTime((kernel->stats->totalTicks - kernel->currentThread->getStartBurstTime() + kernel->currentThread->getBurstTime()) / 2.0 );
-    		kernel->currentThread->setStartBurstTime(kernel->stats->totalTicks);
-
 			SysNice(val);
 			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
 			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
 			return;
 			ASSERTNOTREACHED();
     		break;
+	case SC_Create:
+			val = kernel->machine->ReadRegister(4);
+			status = SysCreate(/* char *name */val);
+			DEBUG(dbgSys, "Create returning with " << status << "\n");
+			kernel->machine->WriteRegister(2, status);
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+			return;
+			ASSERTNOTREACHED();
+			break;
+	case SC_Open:
+			val = kernel->machine->ReadRegister(4);
+			status = SysOpen(/* char *name */val);
+			DEBUG(dbgSys, "Open returning with " << status << "\n");
+			kernel->machine->WriteRegister(2, status);
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+			return;
+			ASSERTNOTREACHED();
+			break;
+	case SC_Read:
+			status = SysRead(/* char *buffer */kernel->machine->ReadRegister(4),
+				/* int size */kernel->machine->ReadRegister(5),
+				/* OpenFileId id */kernel->machine->ReadRegister(6));
+			DEBUG(dbgSys, "Read returning with " << status << "\n");
+			kernel->machine->WriteRegister(2, status);
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+			return;
+			ASSERTNOTREACHED();
+			break;
+	case SC_Write:
+			status = SysWrite(/* char *buffer */kernel->machine->ReadRegister(4),
+				/* int size */kernel->machine->ReadRegister(5),
+				/* OpenFileId id */kernel->machine->ReadRegister(6));
+			DEBUG(dbgSys, "Write returning with " << status << "\n");
+			kernel->machine->WriteRegister(2, status);
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+			return;
+			ASSERTNOTREACHED();
+			break;
+	case SC_Close:
+			val = kernel->machine->ReadRegister(4);
+			status = SysClose(/* OpenFileId id */val);
+			DEBUG(dbgSys, "Close returning with " << status << "\n");
+			kernel->machine->WriteRegister(2, status);
+			kernel->machine->WriteRegister(PCReg, kernel->machine->ReadRegister(PCReg) + 4);
+			kernel->machine->WriteRegister(NextPCReg, kernel->machine->ReadRegister(PCReg)+4);
+			return;
+			ASSERTNOTREACHED();
+			break;
 		case SC_Exit:
 			DEBUG(dbgAddr, "Program exit\n");
             val=kernel->machine->ReadRegister(4);
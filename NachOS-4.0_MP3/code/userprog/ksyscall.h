@@ -12,6 +12,10 @@
 #define __USERPROG_KSYSCALL_H__ 
 
 #include "kernel.h"
+#include "synchconsole.h"
+#ifndef FILESYS_STUB
+#include "filehdr.h"
+#endif
 
 
 
@@ -33,6 +37,154 @@ void SysPrintInt(int number)
 void SysNice(int priority)// OAO
 {
 	// do
+	kernel->scheduler->Charge(kernel->currentThread);// at the old weight
 	kernel->currentThread->setPriority(priority);
 }
+
+// Files have a fixed size in the real Nachos file system, and the
+// Create syscall doesn't give one, so make them as big as they can be.
+#define UserFileSize	MaxFileSize
+
+// Longest file name a program may pass in
+#define MaxNameLength	256
+
+/* Copy the NUL-terminated string at user address "vaddr" into "name".
+ * Return FALSE on a bad address, or if it doesn't fit. */
+static bool
+ReadUserString(int vaddr, char *name, int size)
+{
+	AddrSpace *space = kernel->currentThread->space;
+	unsigned int paddr;
+
+	for (int i = 0; i < size; i++) {
+		if (space->Translate(vaddr + i, &paddr, 0) != NoException)
+			return FALSE;
+		name[i] = kernel->machine->mainMemory[paddr];
+		if (name[i] == '\0')
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/* Move "size" bytes between an open file and the user buffer at
+ * "vaddr", straight to/from main memory, a page at a time (pages that
+ * are contiguous in the user's address space need not be in physical
+ * memory).  Return the # of bytes moved, or -1 if the buffer starts
+ * at a bad address. */
+static int
+UserFileIO(OpenFile *file, int vaddr, int size, bool toUser)
+{
+	AddrSpace *space = kernel->currentThread->space;
+	unsigned int paddr;
+	int done = 0, chunk, result;
+	char *memory;
+
+	while (done < size) {
+		if (space->Translate(vaddr + done, &paddr, toUser) != NoException)
+			return (done > 0) ? done : -1;
+		chunk = min(size - done, PageSize - (int) ((vaddr + done) % PageSize));
+		memory = &kernel->machine->mainMemory[paddr];
+		if (toUser)
+			result = file->Read(memory, chunk);
+		else
+			result = file->Write(memory, chunk);
+		done += result;
+		if (result < chunk)
+			break;		// end of file
+	}
+	return done;
+}
+
+/* Same as above, for the console.  Output goes to the display a page
+ * at a time, as above, so it is buffered and sent out in bursts.  Input
+ * stops at the end of a line, as on a UNIX terminal, and returns 0 at
+ * end of file. */
+static int
+UserConsoleIO(int vaddr, int size, bool toUser)
+{
+	AddrSpace *space = kernel->currentThread->space;
+	unsigned int paddr;
+	int done = 0, chunk, result;
+	char *memory;
+
+	while (done < size) {
+		if (space->Translate(vaddr + done, &paddr, toUser) != NoException)
+			return (done > 0) ? done : -1;
+		chunk = min(size - done, PageSize - (int) ((vaddr + done) % PageSize));
+		memory = &kernel->machine->mainMemory[paddr];
+		if (toUser) {
+			result = kernel->synchConsoleIn->GetChars(memory, chunk);
+			done += result;
+			if (result < chunk || memory[result - 1] == '\n')
+				break;		// end of line, or of file
+		} else {
+			kernel->synchConsoleOut->PutChars(memory, chunk);
+			done += chunk;
+		}
+	}
+	return done;
+}
+
+int SysCreate(int nameAddr)
+{
+	char name[MaxNameLength];
+
+	if (!ReadUserString(nameAddr, name, MaxNameLength))
+		return -1;
+#ifdef FILESYS_STUB
+	return kernel->fileSystem->Create(name) ? 1 : -1;
+#else
+	return kernel->fileSystem->Create(name, UserFileSize) ? 1 : -1;
+#endif
+}
+
+OpenFileId SysOpen(int nameAddr)
+{
+	char name[MaxNameLength];
+	OpenFile *file;
+	OpenFileId id;
+
+	if (!ReadUserString(nameAddr, name, MaxNameLength))
+		return -1;
+	file = kernel->fileSystem->Open(name);
+	if (file == NULL)
+		return -1;
+	id = kernel->currentThread->space->AddFile(file);
+	if (id == -1)
+		delete file;		// too many open files
+	return id;
+}
+
+int SysRead(int buffer, int size, OpenFileId id)
+{
+	OpenFile *file;
+
+	if (size < 0)
+		return -1;
+	if (id == ConsoleInput)
+		return UserConsoleIO(buffer, size, TRUE);
+	file = kernel->currentThread->space->GetFile(id);
+	if (file == NULL)
+		return -1;
+	return UserFileIO(file, buffer, size, TRUE);
+}
+
+int SysWrite(int buffer, int size, OpenFileId id)
+{
+	OpenFile *file;
+
+	if (size < 0)
+		return -1;
+	if (id == ConsoleOutput)
+		return UserConsoleIO(buffer, size, FALSE);
+	file = kernel->currentThread->space->GetFile(id);
+	if (file == NULL)
+		return -1;
+	return UserFileIO(file, buffer, size, FALSE);
+}
+
+int SysClose(OpenFileId id)
+{
+	return kernel->currentThread->space->CloseFile(id) ? 1 : -1;
+}
 #endif /* ! __USERPROG_KSYSCALL_H__ */
@@ -8,6 +8,13 @@
 
 #include "copyright.h"
 #include "synchconsole.h"
+#include "main.h"
+
+// Editing characters
+#define CtrlD	'\004'		// end the line, or the input
+#define CtrlU	'\025'		// erase the line
+#define Erase	'\b'		// erase the last character
+#define Delete	'\177'		// same
 
 //----------------------------------------------------------------------
 // SynchConsoleInput::SynchConsoleInput
@@ -22,6 +29,9 @@ SynchConsoleInput::SynchConsoleInput(char *inputFile)
     consoleInput = new ConsoleInput(inputFile, this);
     lock = new Lock("console in");
     waitFor = new Semaphore("console in", 0);
+    waiting = FALSE;
+    first = count = numReady = 0;
+    endOfFile = FALSE;
 }
 
 //----------------------------------------------------------------------
@@ -36,6 +46,44 @@ SynchConsoleInput::~SynchConsoleInput()
     delete waitFor;
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleInput::GetChars
+//      Read characters typed at the keyboard into "data", up to "n" of
+//	them or to the end of the line, whichever comes first.  Wait
+//	for a complete line, if there isn't one.  Return the number of
+//	characters read, or 0 at end of file.
+//----------------------------------------------------------------------
+
+int
+SynchConsoleInput::GetChars(char *data, int n)
+{
+    IntStatus oldLevel;
+    int done = 0;
+    char ch;
+
+    lock->Acquire();
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    while (numReady == 0 && !endOfFile && !consoleInput->AtEOF()) {
+	consoleInput->Poll();
+	waiting = TRUE;
+	waitFor->P();	// wait for a line, or EOF
+    }
+    if (numReady == 0)
+	endOfFile = FALSE;	// ^D is read only once
+    while (done < n && numReady > 0) {
+	ch = line[first];
+	first = (first + 1) % ConsoleLineSize;
+	count--;
+	numReady--;
+	data[done++] = ch;
+	if (ch == '\n')
+	    break;
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    lock->Release();
+    return done;
+}
+
 //----------------------------------------------------------------------
 // SynchConsoleInput::GetChar
 //      Read a character typed at the keyboard, waiting if necessary.
@@ -46,23 +94,72 @@ SynchConsoleInput::GetChar()
 {
     char ch;
 
-    lock->Acquire();
-    waitFor->P();	// wait for EOF or a char to be available.
-    ch = consoleInput->GetChar();
-    lock->Release();
+    if (GetChars(&ch, 1) == 0)
+	return EOF;
     return ch;
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleInput::Cook
+//      Add a typed character to the line being typed, or edit the
+//	line as the character says.  A line that fills the buffer is
+//	ended; characters typed with the buffer full of lines no one
+//	has read are dropped.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleInput::Cook(char ch)
+{
+    switch (ch) {
+      case Erase:
+      case Delete:
+	if (count > numReady)
+	    count--;
+	break;
+      case CtrlU:
+	count = numReady;
+	break;
+      case CtrlD:
+	if (count == numReady)
+	    endOfFile = TRUE;
+	else
+	    numReady = count;
+	break;
+      default:
+	if (count == ConsoleLineSize)
+	    break;
+	line[(first + count) % ConsoleLineSize] = ch;
+	count++;
+	if (ch == '\n' || count == ConsoleLineSize)
+	    numReady = count;
+    }
+}
+
 //----------------------------------------------------------------------
 // SynchConsoleInput::CallBack
-//      Interrupt handler called when keystroke is hit; wake up
-//	anyone waiting.
+//      Interrupt handler called when keystrokes arrive, or the input
+//	ends.  Cook the keystrokes, then wake up the reader, if a line
+//	is now complete; if not, keep watching the keyboard.
 //----------------------------------------------------------------------
 
 void
 SynchConsoleInput::CallBack()
 {
-    waitFor->V();
+    char typed[ConsoleReadSize];
+    int n;
+
+    n = consoleInput->GetChars(typed, ConsoleReadSize);
+    for (int i = 0; i < n; i++)
+	Cook(typed[i]);
+    if (consoleInput->AtEOF())
+	numReady = count;	// what's left is the last line
+    if (!waiting)
+	return;
+    if (numReady > 0 || endOfFile || consoleInput->AtEOF()) {
+	waiting = FALSE;
+	waitFor->V();
+    } else 
+	consoleInput->Poll();
 }
 
 //----------------------------------------------------------------------
@@ -71,13 +168,16 @@ SynchConsoleInput::CallBack()
 //
 //      "outputFile" -- if NULL, use stdout as console device
 //              otherwise, read from this file
+//	"bufferSize" -- # of characters the display can buffer
 //----------------------------------------------------------------------
 
-SynchConsoleOutput::SynchConsoleOutput(char *outputFile)
+SynchConsoleOutput::SynchConsoleOutput(char *outputFile, int bufferSize)
 {
-    consoleOutput = new ConsoleOutput(outputFile, this);
+    consoleOutput = new ConsoleOutput(outputFile, this, bufferSize);
     lock = new Lock("console out");
     waitFor = new Semaphore("console out", 0);
+    waiting = FALSE;
+    writeThrough = (bufferSize == 1);
 }
 
 //----------------------------------------------------------------------
@@ -92,6 +192,52 @@ SynchConsoleOutput::~SynchConsoleOutput()
     delete waitFor;
 }
 
+//----------------------------------------------------------------------
+// SynchConsoleOutput::Wait
+//      Wait for the display's next interrupt.  Interrupts must be
+//	off, so that we can't miss it between deciding to wait and 
+//	saying so.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::Wait()
+{
+    ASSERT(kernel->interrupt->getLevel() == IntOff);
+    waiting = TRUE;
+    waitFor->P();
+}
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutChars
+//      Write "data[0..n-1]" to the console display.  Hand the device
+//	as much as its buffer has room for, waiting for a burst to go
+//	out only when it is full; so we usually return before the 
+//	characters have reached the display.
+//
+//	Without -cobuf, the display holds just one character, and we
+//	wait for each one to be displayed, as Nachos always did, so
+//	writers block (and threads are scheduled) just as before.
+//----------------------------------------------------------------------
+
+void
+SynchConsoleOutput::PutChars(char *data, int n)
+{
+    IntStatus oldLevel;
+    int done;
+
+    lock->Acquire();
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    while (n > 0) {
+	done = consoleOutput->PutChars(data, n);
+	if (done == 0 || writeThrough)
+	    Wait();	// buffer full, or until it is displayed
+	data += done;
+	n -= done;
+    }
+    (void) kernel->interrupt->SetLevel(oldLevel);
+    lock->Release();
+}
+
 //----------------------------------------------------------------------
 // SynchConsoleOutput::PutChar
 //      Write a character to the console display, waiting if necessary.
@@ -100,28 +246,42 @@ SynchConsoleOutput::~SynchConsoleOutput()
 void
 SynchConsoleOutput::PutChar(char ch)
 {
-    lock->Acquire();
-    consoleOutput->PutChar(ch);
-    waitFor->P();
-    lock->Release();
+    PutChars(&ch, 1);
 }
+
+//----------------------------------------------------------------------
+// SynchConsoleOutput::PutInt
+//      Write a number to the console display, once what is already
+//	buffered has gone out, and wait until it has been displayed.
+//----------------------------------------------------------------------
+
 void
 SynchConsoleOutput::PutInt(int number)
 {
+    IntStatus oldLevel;
+
     lock->Acquire();
+    oldLevel = kernel->interrupt->SetLevel(IntOff);
+    while (!consoleOutput->IsIdle())
+	Wait();
     consoleOutput->PutInt(number);
-    waitFor->P();
+    Wait();
+    (void) kernel->interrupt->SetLevel(oldLevel);
     lock->Release();
 }
 
 //----------------------------------------------------------------------
 // SynchConsoleOutput::CallBack
-//      Interrupt handler called when it's safe to send the next 
-//	character can be sent to the display.
+//      Interrupt handler called when a burst has gone out to the 
+//	display, so there is room for more; wake up the writer, if
+//	it is waiting.
 //----------------------------------------------------------------------
 
 void
 SynchConsoleOutput::CallBack()
 {
-    waitFor->V();
+    if (waiting) {
+	waiting = FALSE;
+	waitFor->V();
+    }
 }
@@ -4,6 +4,14 @@
 //
 //	NOTE: this abstraction is not completely implemented.
 //
+//	Input is "cooked", as by a UNIX terminal driver: typed characters
+//	are collected into lines, which readers only see once complete
+//	(at a newline, or ^D).  Until then the line can be edited:
+//	backspace (or DEL) erases the last character, and ^U the whole
+//	line.  ^D at the start of a line reads as end of file.  Readers
+//	take turns, and each read returns at most one line, so readers
+//	sharing the console never get parts of the same line.
+//
 // Copyright (c) 1992-1996 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
@@ -17,6 +25,8 @@
 #include "console.h"
 #include "synch.h"
 
+#define ConsoleLineSize	256	// # of characters of typed lines held
+
 // The following two classes define synchronized input and output to
 // a console device
 
@@ -26,26 +36,49 @@ class SynchConsoleInput : public CallBackObj {
     ~SynchConsoleInput();		// Deallocate console device
 
     char GetChar();		// Read a character, waiting if necessary
+    int GetChars(char *data, int n);
+				// Read up to "n" characters of the next
+				// line, waiting if necessary; 0 means
+				// end of file
     
   private:
     ConsoleInput *consoleInput;	// the hardware keyboard
     Lock *lock;			// only one reader at a time
     Semaphore *waitFor;		// wait for callBack
+    bool waiting;		// is the reader waiting for callBack?
 
-    void CallBack();		// called when a keystroke is available
+    char line[ConsoleLineSize];	// typed characters (a circular buffer)
+    int first;			// where the oldest one is
+    int count;			// how many there are
+    int numReady;		// how many are in complete lines
+    bool endOfFile;		// was ^D typed on an empty line?
+
+    void Cook(char ch);		// add a typed character to "line", 
+				// editing as it says
+    void CallBack();		// called when keystrokes are available
 };
 
 class SynchConsoleOutput : public CallBackObj {
   public:
-    SynchConsoleOutput(char *outputFile); // Initialize the console device
+    SynchConsoleOutput(char *outputFile, int bufferSize = 1); 
+				// Initialize the console device
     ~SynchConsoleOutput();
 
     void PutChar(char ch);	// Write a character, waiting if necessary
-    void PutInt(int number);
+    void PutChars(char *data, int n);
+				// Write "n" characters, waiting only
+				// for room in the device's buffer (or,
+				// with no buffer, until each is shown)
+    void PutInt(int number);	// Write a number, waiting until done
   private:
     ConsoleOutput *consoleOutput;// the hardware display
     Lock *lock;			// only one writer at a time
     Semaphore *waitFor;		// wait for callBack
+    bool waiting;		// is the writer waiting for callBack?
+    bool writeThrough;		// wait for each character to go out?
+				// (the display buffers only one)
+
+    void Wait();		// wait for the next callBack
 
     void CallBack();		// called when more data can be written
 };